@@ -2,13 +2,147 @@
 
 #include <openssl/aes.h>
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 
-#include "absl/container/flat_hash_map.h"
+#include "../util/codec.h"
+#include "../util/mapped_file.h"
+#include "../util/parallel.h"
 
 namespace cryptopals {
 
+namespace {
+
+using Block = unsigned __int128;
+
+constexpr size_t kBlockSize = 16;
+constexpr size_t kRecordsPerTask = 256;
+
+// Counts equal blocks with linear probing. The table is reused across
+// records, so after warm-up nothing is allocated.
+class BlockCounter {
+ public:
+  // Clears the table and sizes it for `blocks` insertions.
+  void Reset(size_t blocks) {
+    size_t capacity = 16;
+    while (capacity < 2 * blocks) capacity *= 2;
+    if (capacity > keys_.size()) {
+      keys_.resize(capacity);
+      counts_.resize(capacity);
+    }
+    mask_ = capacity - 1;
+    std::fill(counts_.begin(), counts_.begin() + capacity, 0);
+  }
+
+  // Returns the count of `block` before this insertion.
+  uint32_t Insert(Block block) {
+    auto lo = static_cast<uint64_t>(block);
+    auto hi = static_cast<uint64_t>(block >> 64u);
+    // Ciphertext blocks are uniformly distributed, a cheap mix will do.
+    size_t slot = ((lo ^ hi) * 0x9e3779b97f4a7c15ull >> 32u) & mask_;
+    while (counts_[slot] != 0 && keys_[slot] != block) {
+      slot = (slot + 1) & mask_;
+    }
+    keys_[slot] = block;
+    return counts_[slot]++;
+  }
+
+ private:
+  std::vector<Block> keys_;
+  std::vector<uint32_t> counts_;
+  size_t mask_ = 0;
+};
+
+BlockCounter& ThreadCounter() {
+  thread_local BlockCounter counter;
+  return counter;
+}
+
+Block LoadBlock(const char* data) {
+  Block block;
+  std::memcpy(&block, data, kBlockSize);
+  return block;
+}
+
+// Decodes 32 hex digits into a block.
+Block LoadHexBlock(const char* hex) {
+  uint8_t bytes[kBlockSize];
+  if (!util::HexDecode(hex, 2 * kBlockSize, bytes)) {
+    throw std::runtime_error("invalid hex digit");
+  }
+  Block block;
+  std::memcpy(&block, bytes, kBlockSize);
+  return block;
+}
+
+// Scores `count` blocks, `load(i)` returns block i. `partial` is 1 if there
+// is a trailing partial block.
+template <class Load>
+EcbScore ScoreBlocks(size_t count, const Load& load, size_t partial) {
+  BlockCounter& counter = ThreadCounter();
+  counter.Reset(count);
+  EcbScore score{0, 0, static_cast<uint32_t>(count + partial)};
+  for (size_t i = 0; i < count; i++) {
+    // (c + 1)^2 - c^2
+    score.uniqueness += 2 * counter.Insert(load(i)) + 1;
+  }
+  score.uniqueness += partial;
+  return score;
+}
+
+EcbScore ScoreCiphertext(std::string_view ciphertext) {
+  const char* data = ciphertext.data();
+  return ScoreBlocks(
+      ciphertext.size() / kBlockSize,
+      [data](size_t i) { return LoadBlock(data + i * kBlockSize); },
+      ciphertext.size() % kBlockSize != 0);
+}
+
+EcbScore ScoreHexLine(std::string_view line) {
+  while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) {
+    line.remove_suffix(1);
+  }
+  const char* data = line.data();
+  constexpr size_t kHexBlockSize = 2 * kBlockSize;
+  const size_t tail = line.size() % kHexBlockSize;
+  uint8_t bytes[kBlockSize];
+  if (tail != 0 &&
+      !util::HexDecode(data + line.size() - tail, tail, bytes)) {
+    throw std::runtime_error("invalid hex digit or odd line length");
+  }
+  return ScoreBlocks(
+      line.size() / kHexBlockSize,
+      [data](size_t i) { return LoadHexBlock(data + i * kHexBlockSize); },
+      tail != 0);
+}
+
+template <class ScoreRecord>
+std::vector<EcbScore> ScoreRecords(size_t count, const ScoreRecord& score,
+                                   unsigned threads) {
+  // Every record gets a slot, so the output order does not depend on
+  // scheduling; only the ECB ones are kept.
+  std::vector<EcbScore> scores(count);
+  util::ParallelFor(
+      count, kRecordsPerTask,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          scores[i] = score(i);
+          scores[i].index = i;
+        }
+      },
+      threads);
+  std::vector<EcbScore> ecb;
+  for (const auto& s : scores) {
+    if (s.uniqueness > s.blocks) ecb.push_back(s);
+  }
+  return ecb;
+}
+
+}  // namespace
+
 std::string DecryptAesInEcbMode(std::string_view ciphertext,
                                 std::string_view key) {
   AES_KEY aes_key;
@@ -36,15 +170,69 @@ std::string DecryptAesInEcbMode(std::string_view ciphertext,
 
 // Original idea from kunin@
 EcbPattern GetEcbPattern(std::string_view ciphertext) {
-  EcbPattern result = {.ciphertext = std::string(ciphertext), .uniqueness = 0};
-  absl::flat_hash_map<std::string, uint32_t> blob_map;
-  for (size_t i = 0; i < ciphertext.size(); i += 16) {
-    blob_map[ciphertext.substr(i, 16)] += 1;
+  return {.ciphertext = std::string(ciphertext),
+          .uniqueness = EcbUniqueness(ciphertext)};
+}
+
+uint32_t EcbUniqueness(std::string_view ciphertext) {
+  return ScoreCiphertext(ciphertext).uniqueness;
+}
+
+size_t CountRepeatedBlocks(std::string_view ciphertext) {
+  const size_t count = ciphertext.size() / kBlockSize;
+  BlockCounter& counter = ThreadCounter();
+  counter.Reset(count);
+  size_t repeated = 0;
+  for (size_t i = 0; i < count; i++) {
+    repeated += counter.Insert(LoadBlock(&ciphertext[i * kBlockSize])) != 0;
+  }
+  return repeated;
+}
+
+std::vector<EcbScore> FindEcbRecords(std::string_view buffer,
+                                     const std::vector<size_t>& offsets,
+                                     unsigned threads) {
+  if (offsets.size() < 2) {
+    return {};
+  }
+  return ScoreRecords(
+      offsets.size() - 1,
+      [buffer, &offsets](size_t i) {
+        return ScoreCiphertext(
+            buffer.substr(offsets[i], offsets[i + 1] - offsets[i]));
+      },
+      threads);
+}
+
+std::vector<EcbScore> FindEcbRecordsInHexFile(const std::string& path,
+                                              unsigned threads) {
+  const util::MappedFile file = util::MappedFile::Open(path);
+  file.AdviseSequential();
+  std::string_view text = file.data();
+  if (text.empty()) {
+    return {};
+  }
+
+  // Line starts; a record is its line without the newline.
+  std::vector<size_t> offsets = {0};
+  for (size_t pos = text.find('\n'); pos != std::string_view::npos;
+       pos = text.find('\n', pos + 1)) {
+    offsets.push_back(pos + 1);
+  }
+  if (offsets.back() != text.size()) {
+    offsets.push_back(text.size());
   }
-  for (auto& [content, count] : blob_map) {
-    result.uniqueness += count * count;
+  try {
+    return ScoreRecords(
+        offsets.size() - 1,
+        [text, &offsets](size_t i) {
+          return ScoreHexLine(
+              text.substr(offsets[i], offsets[i + 1] - offsets[i]));
+        },
+        threads);
+  } catch (const std::runtime_error&) {
+    throw std::runtime_error("Invalid hex line in " + path);
   }
-  return result;
 }
 
-}  // namespace cryptopals
\ No newline at end of file
+}  // namespace cryptopals
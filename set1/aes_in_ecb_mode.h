@@ -1,7 +1,11 @@
 #ifndef CRYPTOPALS_SET1_AES_IN_ECB_MODE_H_
 #define CRYPTOPALS_SET1_AES_IN_ECB_MODE_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace cryptopals {
 
@@ -16,6 +20,35 @@ std::string DecryptAesInEcbMode(std::string_view ciphertext,
 
 EcbPattern GetEcbPattern(std::string_view ciphertext);
 
+// EcbPattern::uniqueness without copying `ciphertext`. Blocks are loaded as
+// 128-bit integers and counted in an open-addressing table, nothing is
+// allocated per block. A trailing partial block counts as unique.
+uint32_t EcbUniqueness(std::string_view ciphertext);
+
+// Number of blocks equal to an earlier block of `ciphertext`; any repeat
+// gives ECB away.
+size_t CountRepeatedBlocks(std::string_view ciphertext);
+
+struct EcbScore {
+  size_t index;  // record number
+  uint32_t uniqueness;
+  uint32_t blocks;  // uniqueness == blocks if no block repeats
+};
+
+// Scores every record of `buffer`, record i being
+// buffer[offsets[i], offsets[i + 1]), on `threads` workers (0 means all
+// cores). Returns the records with repeated blocks, in record order.
+std::vector<EcbScore> FindEcbRecords(std::string_view buffer,
+                                     const std::vector<size_t>& offsets,
+                                     unsigned threads = 0);
+
+// Same as above for a file of hex encoded ciphertexts, one per line, as in
+// challenge 8. The file is memory-mapped and blocks are decoded straight
+// from the mapping. Throws std::runtime_error if the file cannot be read or
+// a line is not valid hex.
+std::vector<EcbScore> FindEcbRecordsInHexFile(const std::string& path,
+                                              unsigned threads = 0);
+
 }  // namespace cryptopals
 
 #endif  // CRYPTOPALS_SET1_AES_IN_ECB_MODE_H_
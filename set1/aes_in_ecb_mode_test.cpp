@@ -1,6 +1,7 @@
 #include "aes_in_ecb_mode.h"
 
 #include <fstream>
+#include <stdexcept>
 
 #include "absl/strings/escaping.h"
 #include "gtest/gtest.h"
@@ -57,5 +58,51 @@ TEST(AesInEcbModeTest, DetectAesInEcbMode) {
       absl::BytesToHexString(best.ciphertext));
 }
 
+TEST(AesInEcbModeTest, FindEcbRecords) {
+  std::ifstream file("detect_aes_in_ecb_mode.txt",
+                     std::ios::in | std::ios::binary);
+  ASSERT_TRUE(file.is_open());
+  std::string buffer;
+  std::vector<size_t> offsets = {0};
+  std::string line;
+  while (std::getline(file, line)) {
+    buffer += absl::HexStringToBytes(line);
+    offsets.push_back(buffer.size());
+  }
+
+  for (unsigned threads : {1, 4}) {
+    auto records = FindEcbRecords(buffer, offsets, threads);
+    ASSERT_EQ(1, records.size());
+    EXPECT_EQ(132, records[0].index);
+    EXPECT_EQ(10, records[0].blocks);
+    // One block appears 4 times, 6 others once.
+    EXPECT_EQ(4 * 4 + 6, records[0].uniqueness);
+  }
+
+  auto from_file = FindEcbRecordsInHexFile("detect_aes_in_ecb_mode.txt");
+  ASSERT_EQ(1, from_file.size());
+  EXPECT_EQ(132, from_file[0].index);
+  EXPECT_EQ(4 * 4 + 6, from_file[0].uniqueness);
+  EXPECT_THROW(FindEcbRecordsInHexFile("no_such_file"), std::runtime_error);
+
+  const std::string bad_path = ::testing::TempDir() + "aes_in_ecb_mode_bad.txt";
+  const std::string block(32, 'a');
+  for (const std::string& bad_line :
+       {block + "x" + block.substr(1), block + block + "abc"}) {
+    std::ofstream(bad_path) << block + block << "\n" << bad_line << "\n";
+    EXPECT_THROW(FindEcbRecordsInHexFile(bad_path), std::runtime_error);
+  }
+}
+
+TEST(AesInEcbModeTest, RepeatedBlocks) {
+  std::string block_a(16, 'a'), block_b(16, 'b');
+  std::string ciphertext = block_a + block_b + block_a + block_a + "tail";
+  EXPECT_EQ(2, CountRepeatedBlocks(ciphertext));
+  // 3^2 + 1^2 + 1 for the partial block
+  EXPECT_EQ(11, EcbUniqueness(ciphertext));
+  EXPECT_EQ(0, CountRepeatedBlocks(block_a + block_b));
+  EXPECT_EQ(0, EcbUniqueness(""));
+}
+
 }  // namespace
 }  // namespace cryptopals
\ No newline at end of file
@@ -1,16 +1,130 @@
 #include "fixed_xor.h"
 
 #include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CRYPTOPALS_X86 1
+#endif
 
 namespace cryptopals {
 
+namespace {
+
+using XorKernel = void (*)(uint8_t*, const uint8_t*, const uint8_t*, size_t);
+
+// Word at a time, the compiler keeps the memcpy as plain loads and stores.
+void XorTail(uint8_t* dst, const uint8_t* src1, const uint8_t* src2,
+             size_t size) {
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t a, b;
+    std::memcpy(&a, src1 + i, 8);
+    std::memcpy(&b, src2 + i, 8);
+    a ^= b;
+    std::memcpy(dst + i, &a, 8);
+  }
+  for (; i < size; i++) {
+    dst[i] = src1[i] ^ src2[i];
+  }
+}
+
+#ifdef CRYPTOPALS_X86
+__attribute__((target("sse2"))) void XorSse2(uint8_t* dst,
+                                             const uint8_t* src1,
+                                             const uint8_t* src2,
+                                             size_t size) {
+  size_t i = 0;
+  for (; i + 64 <= size; i += 64) {
+    for (size_t j = i; j < i + 64; j += 16) {
+      __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src1 + j));
+      __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src2 + j));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + j),
+                       _mm_xor_si128(a, b));
+    }
+  }
+  for (; i + 16 <= size; i += 16) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src1 + i));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src2 + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(a, b));
+  }
+  XorTail(dst + i, src1 + i, src2 + i, size - i);
+}
+
+__attribute__((target("avx2"))) void XorAvx2(uint8_t* dst,
+                                             const uint8_t* src1,
+                                             const uint8_t* src2,
+                                             size_t size) {
+  size_t i = 0;
+  // Four independent vectors per iteration keep both load ports busy.
+  for (; i + 128 <= size; i += 128) {
+    for (size_t j = i; j < i + 128; j += 32) {
+      __m256i a =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src1 + j));
+      __m256i b =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src2 + j));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + j),
+                          _mm256_xor_si256(a, b));
+    }
+  }
+  for (; i + 32 <= size; i += 32) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src1 + i));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src2 + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                        _mm256_xor_si256(a, b));
+  }
+  XorTail(dst + i, src1 + i, src2 + i, size - i);
+}
+#endif
+
+XorKernel SelectKernel() {
+#ifdef CRYPTOPALS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return XorAvx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return XorSse2;
+  }
+#endif
+  return XorTail;
+}
+
+}  // namespace
+
+void XorBytes(uint8_t* dst, const uint8_t* src1, const uint8_t* src2,
+              size_t size) {
+  static const XorKernel kernel = SelectKernel();
+  // Small inputs (a single AES block) are not worth the indirect call.
+  if (size <= 16) {
+    XorTail(dst, src1, src2, size);
+    return;
+  }
+  kernel(dst, src1, src2, size);
+}
+
 std::string FixedXor(std::string_view str1, std::string_view str2) {
-  size_t size = std::min(str1.size(), str2.size());
   std::string output;
-  for (size_t i = 0; i < size; i++) {
-    output.push_back((unsigned char)str1.at(i) ^ (unsigned char)str2.at(i));
-  }
+  FixedXorAppend(str1, str2, &output);
   return output;
 }
 
-}  // namespace cryptopals
\ No newline at end of file
+void FixedXorInPlace(std::string* str1, std::string_view str2) {
+  size_t size = std::min(str1->size(), str2.size());
+  str1->resize(size);
+  auto* dst = reinterpret_cast<uint8_t*>(str1->data());
+  XorBytes(dst, dst, reinterpret_cast<const uint8_t*>(str2.data()), size);
+}
+
+void FixedXorAppend(std::string_view str1, std::string_view str2,
+                    std::string* output) {
+  size_t size = std::min(str1.size(), str2.size());
+  size_t offset = output->size();
+  output->resize(offset + size);
+  XorBytes(reinterpret_cast<uint8_t*>(output->data()) + offset,
+           reinterpret_cast<const uint8_t*>(str1.data()),
+           reinterpret_cast<const uint8_t*>(str2.data()), size);
+}
+
+}  // namespace cryptopals
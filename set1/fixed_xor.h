@@ -1,6 +1,8 @@
 #ifndef CRYPTOPALS_SET1_FIXED_XOR_H_
 #define CRYPTOPALS_SET1_FIXED_XOR_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <string_view>
 
@@ -11,6 +13,20 @@ namespace cryptopals {
 // .size(), str2.size()) bytes if str1 and str2 have different length.
 std::string FixedXor(std::string_view str1, std::string_view str2);
 
+// Same as FixedXor, but writes the result into `str1` (resized to the shorter
+// length).
+void FixedXorInPlace(std::string* str1, std::string_view str2);
+
+// Same as FixedXor, but appends the result to `output`.
+void FixedXorAppend(std::string_view str1, std::string_view str2,
+                    std::string* output);
+
+// dst[i] = src1[i] ^ src2[i] for i < size. `dst` may be the same buffer as
+// either source, but must not overlap them otherwise. Runs 32 (AVX2) or 16
+// (SSE2) bytes per step, depending on what the CPU supports.
+void XorBytes(uint8_t* dst, const uint8_t* src1, const uint8_t* src2,
+              size_t size);
+
 }  // namespace cryptopals
 
-#endif  // CRYPTOPALS_SET1_FIXED_XOR_H_
\ No newline at end of file
+#endif  // CRYPTOPALS_SET1_FIXED_XOR_H_
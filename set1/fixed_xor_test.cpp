@@ -1,5 +1,7 @@
 #include "fixed_xor.h"
 
+#include <algorithm>
+
 #include "absl/strings/escaping.h"
 #include "gtest/gtest.h"
 
@@ -16,5 +18,38 @@ TEST(FixedXorTest, Test) {
   EXPECT_EQ(result, FixedXor(str1, str2));
 }
 
+std::string NaiveXor(std::string_view str1, std::string_view str2) {
+  std::string output;
+  for (size_t i = 0; i < std::min(str1.size(), str2.size()); i++) {
+    output.push_back(static_cast<char>(str1[i] ^ str2[i]));
+  }
+  return output;
+}
+
+TEST(FixedXorTest, AllSizesAndOffsets) {
+  std::string data1, data2;
+  for (int i = 0; i < 600; i++) {
+    data1.push_back(static_cast<char>(i * 7 + 3));
+    data2.push_back(static_cast<char>(i * 13 + 5));
+  }
+  // Sizes around every vector width, unaligned starts
+  for (size_t offset = 0; offset < 4; offset++) {
+    for (size_t size = 0; size + offset <= 300; size++) {
+      std::string_view str1 = std::string_view(data1).substr(offset, size);
+      std::string_view str2 = std::string_view(data2).substr(0, size + offset);
+      std::string expected = NaiveXor(str1, str2);
+      ASSERT_EQ(expected, FixedXor(str1, str2)) << size;
+
+      std::string in_place(str1);
+      FixedXorInPlace(&in_place, str2);
+      ASSERT_EQ(expected, in_place);
+
+      std::string appended = "prefix";
+      FixedXorAppend(str1, str2, &appended);
+      ASSERT_EQ("prefix" + expected, appended);
+    }
+  }
+}
+
 }  // namespace
 }  // namespace cryptopals
\ No newline at end of file
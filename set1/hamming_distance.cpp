@@ -0,0 +1,158 @@
+#include "hamming_distance.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CRYPTOPALS_X86 1
+#endif
+
+namespace cryptopals {
+
+namespace {
+
+using HammingKernel = uint64_t (*)(const uint8_t*, const uint8_t*, size_t);
+
+// AVX2 only pays off once a few vectors are in flight.
+constexpr size_t kMinVectorSize = 64;
+
+uint64_t HammingWords(const uint8_t* a, const uint8_t* b, size_t size) {
+  uint64_t dist = 0;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t x, y;
+    std::memcpy(&x, a + i, 8);
+    std::memcpy(&y, b + i, 8);
+    dist += __builtin_popcountll(x ^ y);
+  }
+  for (; i < size; i++) {
+    dist += __builtin_popcount(static_cast<uint8_t>(a[i] ^ b[i]));
+  }
+  return dist;
+}
+
+#ifdef CRYPTOPALS_X86
+// Same loop, compiled to the POPCNT instruction.
+__attribute__((target("popcnt"))) uint64_t HammingPopcnt(const uint8_t* a,
+                                                         const uint8_t* b,
+                                                         size_t size) {
+  uint64_t dist = 0;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t x, y;
+    std::memcpy(&x, a + i, 8);
+    std::memcpy(&y, b + i, 8);
+    dist += __builtin_popcountll(x ^ y);
+  }
+  for (; i < size; i++) {
+    dist += __builtin_popcount(static_cast<uint8_t>(a[i] ^ b[i]));
+  }
+  return dist;
+}
+
+// Muła's nibble lookup: the popcount of each 4-bit half comes from a 16-entry
+// table via vpshufb, and vpsadbw folds the byte counts into 64-bit lanes.
+__attribute__((target("avx2,popcnt"))) uint64_t HammingAvx2(const uint8_t* a,
+                                                            const uint8_t* b,
+                                                            size_t size) {
+  const __m256i lookup =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1,
+                       1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8(0x0f);
+  __m256i total = _mm256_setzero_si256();
+  size_t i = 0;
+  while (i + 32 <= size) {
+    // Byte counters hold at most 8 per vector, so 31 vectors fit in a byte.
+    __m256i counts = _mm256_setzero_si256();
+    size_t end = std::min(size - size % 32, i + 31 * 32);
+    for (; i < end; i += 32) {
+      __m256i x = _mm256_xor_si256(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+      __m256i lo = _mm256_and_si256(x, low_mask);
+      __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), low_mask);
+      counts = _mm256_add_epi8(counts, _mm256_shuffle_epi8(lookup, lo));
+      counts = _mm256_add_epi8(counts, _mm256_shuffle_epi8(lookup, hi));
+    }
+    total = _mm256_add_epi64(total,
+                             _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+  }
+  uint64_t dist = static_cast<uint64_t>(_mm256_extract_epi64(total, 0)) +
+                  static_cast<uint64_t>(_mm256_extract_epi64(total, 1)) +
+                  static_cast<uint64_t>(_mm256_extract_epi64(total, 2)) +
+                  static_cast<uint64_t>(_mm256_extract_epi64(total, 3));
+  return dist + HammingPopcnt(a + i, b + i, size - i);
+}
+#endif
+
+struct Kernels {
+  HammingKernel words = HammingWords;
+  HammingKernel vector = HammingWords;
+};
+
+Kernels SelectKernels() {
+  Kernels kernels;
+#ifdef CRYPTOPALS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("popcnt")) {
+    kernels.words = kernels.vector = HammingPopcnt;
+    if (__builtin_cpu_supports("avx2")) {
+      kernels.vector = HammingAvx2;
+    }
+  }
+#endif
+  return kernels;
+}
+
+const Kernels& GetKernels() {
+  static const Kernels kernels = SelectKernels();
+  return kernels;
+}
+
+}  // namespace
+
+uint64_t HammingDistance(const uint8_t* a, const uint8_t* b, size_t size) {
+  const Kernels& kernels = GetKernels();
+  return size < kMinVectorSize ? kernels.words(a, b, size)
+                               : kernels.vector(a, b, size);
+}
+
+uint64_t HammingDistance(std::string_view a, std::string_view b) {
+  return HammingDistance(reinterpret_cast<const uint8_t*>(a.data()),
+                         reinterpret_cast<const uint8_t*>(b.data()),
+                         std::min(a.size(), b.size()));
+}
+
+std::vector<uint32_t> AdjacentBlockDistances(std::string_view data,
+                                             size_t block_size) {
+  std::vector<uint32_t> distances;
+  if (block_size == 0 || data.size() / block_size < 2) {
+    return distances;
+  }
+  size_t pairs = data.size() / block_size - 1;
+  distances.resize(pairs);
+  const auto* bytes = reinterpret_cast<const uint8_t*>(data.data());
+  // Picking the kernel once keeps small blocks (key sizes are 2 to 40 bytes)
+  // from paying for the dispatch on every pair.
+  const Kernels& kernels = GetKernels();
+  HammingKernel kernel =
+      block_size < kMinVectorSize ? kernels.words : kernels.vector;
+  for (size_t i = 0; i < pairs; i++) {
+    const uint8_t* block = bytes + i * block_size;
+    distances[i] =
+        static_cast<uint32_t>(kernel(block, block + block_size, block_size));
+  }
+  return distances;
+}
+
+uint64_t TotalAdjacentBlockDistance(std::string_view data, size_t block_size) {
+  if (block_size == 0 || data.size() / block_size < 2) {
+    return 0;
+  }
+  size_t size = (data.size() / block_size - 1) * block_size;
+  const auto* bytes = reinterpret_cast<const uint8_t*>(data.data());
+  return HammingDistance(bytes, bytes + block_size, size);
+}
+
+}  // namespace cryptopals
@@ -0,0 +1,32 @@
+#ifndef CRYPTOPALS_SET1_HAMMING_DISTANCE_H_
+#define CRYPTOPALS_SET1_HAMMING_DISTANCE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace cryptopals {
+
+// Number of differing bits between a[0, size) and b[0, size). Uses an AVX2
+// nibble-LUT popcount for long inputs and hardware POPCNT on 64-bit words
+// otherwise, depending on what the CPU supports.
+uint64_t HammingDistance(const uint8_t* a, const uint8_t* b, size_t size);
+
+// Same as above, over the first min(a.size(), b.size()) bytes.
+uint64_t HammingDistance(std::string_view a, std::string_view b);
+
+// Distances between every pair of adjacent blocks of `data`: element i is the
+// distance between block i and block i + 1. A partial trailing block is
+// ignored. The pairs are computed in one pass over `data`.
+std::vector<uint32_t> AdjacentBlockDistances(std::string_view data,
+                                             size_t block_size);
+
+// Sum of AdjacentBlockDistances(data, block_size), in a single kernel call:
+// the blocks are adjacent, so the pairs together are `data` against itself
+// shifted by `block_size`.
+uint64_t TotalAdjacentBlockDistance(std::string_view data, size_t block_size);
+
+}  // namespace cryptopals
+
+#endif  // CRYPTOPALS_SET1_HAMMING_DISTANCE_H_
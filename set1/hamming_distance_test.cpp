@@ -0,0 +1,67 @@
+#include "hamming_distance.h"
+
+#include <algorithm>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace cryptopals {
+namespace {
+
+uint64_t NaiveDistance(std::string_view a, std::string_view b) {
+  uint64_t dist = 0;
+  for (size_t i = 0; i < std::min(a.size(), b.size()); i++) {
+    for (auto x = static_cast<uint8_t>(a[i] ^ b[i]); x; x >>= 1u) {
+      dist += x & 1u;
+    }
+  }
+  return dist;
+}
+
+std::string TestBytes(size_t size, int seed) {
+  std::string bytes;
+  for (size_t i = 0; i < size; i++) {
+    bytes.push_back(static_cast<char>(i * seed + i / 5 + seed));
+  }
+  return bytes;
+}
+
+TEST(HammingDistanceTest, Example) {
+  EXPECT_EQ(37, HammingDistance("this is a test", "wokka wokka!!!"));
+}
+
+TEST(HammingDistanceTest, MatchesNaive) {
+  // Long enough for the byte counters of the vector kernel to be flushed
+  std::string a = TestBytes(20000, 7);
+  std::string b = TestBytes(20000, 13);
+  for (size_t size :
+       {0, 1, 7, 8, 9, 31, 32, 63, 64, 65, 100, 992, 993, 20000}) {
+    for (size_t offset : {0, 3}) {
+      std::string_view x = std::string_view(a).substr(offset, size);
+      std::string_view y = std::string_view(b).substr(0, size);
+      EXPECT_EQ(NaiveDistance(x, y), HammingDistance(x, y)) << size;
+    }
+  }
+  std::string ones(5000, '\xff');
+  EXPECT_EQ(5000 * 8, HammingDistance(ones, std::string(5000, 0)));
+}
+
+TEST(HammingDistanceTest, AdjacentBlocks) {
+  std::string data = TestBytes(1000, 11);
+  for (size_t block_size : {1, 2, 3, 29, 40, 64, 100, 333, 500, 501}) {
+    std::vector<uint32_t> distances = AdjacentBlockDistances(data, block_size);
+    size_t blocks = data.size() / block_size;
+    ASSERT_EQ(blocks < 2 ? 0 : blocks - 1, distances.size());
+    uint64_t total = 0;
+    for (size_t i = 0; i < distances.size(); i++) {
+      EXPECT_EQ(NaiveDistance(data.substr(i * block_size, block_size),
+                              data.substr((i + 1) * block_size, block_size)),
+                distances[i]);
+      total += distances[i];
+    }
+    EXPECT_EQ(total, TotalAdjacentBlockDistance(data, block_size));
+  }
+}
+
+}  // namespace
+}  // namespace cryptopals
@@ -0,0 +1,83 @@
+#include "key_period.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "../util/parallel.h"
+#include "hamming_distance.h"
+
+namespace cryptopals {
+
+namespace {
+
+// Bytes of `data` compared against all shifts of a range before moving on,
+// so both operands stay in L1/L2 while the shifts sweep over them.
+constexpr size_t kTileSize = 16 * 1024;
+constexpr size_t kShiftsPerTask = 32;
+// Shifts by a multiple of the key length typically score ~0.15 below the
+// others on text. Below this spread every shift looks alike, which is what a
+// single-byte key gives.
+constexpr double kMinContrast = 0.05;
+
+}  // namespace
+
+std::vector<double> BitAutocorrelation(std::string_view data, size_t max_shift,
+                                       unsigned threads) {
+  std::vector<double> scores(max_shift + 1, 1.0);
+  size_t last_shift = std::min(max_shift, data.size() / 2);
+  if (last_shift == 0) {
+    return scores;
+  }
+  const auto* bytes = reinterpret_cast<const uint8_t*>(data.data());
+  const size_t size = data.size();
+  util::ParallelFor(
+      last_shift, kShiftsPerTask,
+      [&](size_t begin, size_t end) {
+        // Shifts begin + 1 .. end
+        std::vector<uint64_t> dist(end - begin);
+        for (size_t tile = 0; tile < size; tile += kTileSize) {
+          for (size_t d = begin + 1; d <= end; d++) {
+            if (tile + d >= size) {
+              break;
+            }
+            size_t len = std::min(kTileSize, size - d - tile);
+            dist[d - begin - 1] += HammingDistance(bytes + tile,
+                                                   bytes + tile + d, len);
+          }
+        }
+        for (size_t d = begin + 1; d <= end; d++) {
+          scores[d] = static_cast<double>(dist[d - begin - 1]) /
+                      (8.0 * static_cast<double>(size - d));
+        }
+      },
+      threads);
+  return scores;
+}
+
+size_t DetectKeyPeriod(std::string_view ciphertext,
+                       const KeyPeriodOptions& options) {
+  size_t last = std::min(options.max_period, ciphertext.size() / 2);
+  if (last == 0) {
+    return 0;
+  }
+  std::vector<double> scores =
+      BitAutocorrelation(ciphertext, last, options.threads);
+  double best = scores[1], mean = 0;
+  for (size_t d = 1; d <= last; d++) {
+    best = std::min(best, scores[d]);
+    mean += scores[d];
+  }
+  mean /= static_cast<double>(last);
+  if (mean - best < kMinContrast) {
+    return 1;
+  }
+  double threshold = best + options.tolerance * (mean - best);
+  for (size_t d = 1; d <= last; d++) {
+    if (scores[d] <= threshold) {
+      return d;
+    }
+  }
+  return 0;  // not reached, the best score is below the threshold
+}
+
+}  // namespace cryptopals
@@ -0,0 +1,39 @@
+#ifndef CRYPTOPALS_SET1_KEY_PERIOD_H_
+#define CRYPTOPALS_SET1_KEY_PERIOD_H_
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace cryptopals {
+
+// Bit-level autocorrelation of `data`: element d (1 <= d <= max_shift) is the
+// fraction of bits that differ between `data` and `data` shifted by d bytes,
+// over their whole overlap. Element 0 is unused. Shifts past half of `data`
+// are not scored (their overlap is too short to be meaningful) and left at 1.
+//
+// For a repeating-key XOR ciphertext, shifting by a multiple of the key
+// length cancels the key, leaving plaintext ^ plaintext, which has far fewer
+// differing bits than unrelated bytes. All shifts are scored with the
+// Hamming kernel over cache-sized tiles of `data`, in parallel across shifts.
+std::vector<double> BitAutocorrelation(std::string_view data, size_t max_shift,
+                                       unsigned threads = 0);
+
+struct KeyPeriodOptions {
+  size_t max_period = 4096;
+  // A period qualifies if its score is within `tolerance` of the best one,
+  // measured as a fraction of the gap between the best and the mean score.
+  // The smallest qualifying period wins, as multiples of the key length
+  // score as well as the key length itself.
+  double tolerance = 0.2;
+  unsigned threads = 0;  // 0 means all cores
+};
+
+// Estimates the key length of a repeating-key XOR ciphertext, or returns 0 if
+// `ciphertext` is too short to tell. Returns 1 if no shift stands out.
+size_t DetectKeyPeriod(std::string_view ciphertext,
+                       const KeyPeriodOptions& options = {});
+
+}  // namespace cryptopals
+
+#endif  // CRYPTOPALS_SET1_KEY_PERIOD_H_
@@ -0,0 +1,63 @@
+#include "key_period.h"
+
+#include "../util/mapped_file.h"
+#include "absl/strings/escaping.h"
+#include "gtest/gtest.h"
+#include "repeat_key_xor.h"
+
+namespace cryptopals {
+namespace {
+
+std::string ReadFile(const std::string& name) {
+  return std::string(util::MappedFile::OpenData(name).data());
+}
+
+std::string TestKey(size_t size) {
+  std::string key;
+  uint32_t x = 12345;
+  for (size_t i = 0; i < size; i++) {
+    x = x * 1103515245 + 12345;
+    key.push_back(static_cast<char>(x >> 16u));
+  }
+  return key;
+}
+
+TEST(KeyPeriodTest, LongKeys) {
+  std::string plaintext = ReadFile("1984.txt");
+  ASSERT_FALSE(plaintext.empty());
+  for (size_t key_size : {1, 3, 29, 97, 1000, 3001}) {
+    std::string ciphertext = RepeatKeyXorEncode(plaintext, TestKey(key_size));
+    EXPECT_EQ(key_size, DetectKeyPeriod(ciphertext));
+  }
+}
+
+TEST(KeyPeriodTest, BreakLongKey) {
+  std::string plaintext = ReadFile("1984.txt").substr(0, 100000);
+  std::string key = TestKey(97);
+  BreakRepeatKeyXorOutput output =
+      BreakRepeatKeyXor(RepeatKeyXorEncode(plaintext, key));
+  EXPECT_EQ(key, output.key);
+  EXPECT_EQ(plaintext, output.plaintext);
+}
+
+TEST(KeyPeriodTest, Challenge6) {
+  std::string ciphertext;
+  ASSERT_TRUE(absl::Base64Unescape(ReadFile("break_repeat_key_xor.txt"),
+                                   &ciphertext));
+  EXPECT_EQ(29, DetectKeyPeriod(ciphertext));
+}
+
+TEST(KeyPeriodTest, Autocorrelation) {
+  std::string data = "abcabcabcabcabcabcabcab";
+  std::vector<double> scores = BitAutocorrelation(data, 15, /*threads=*/1);
+  ASSERT_EQ(16, scores.size());
+  EXPECT_EQ(0, scores[3]);
+  EXPECT_EQ(0, scores[6]);
+  EXPECT_GT(scores[1], 0);
+  // Overlap shorter than half of the data
+  EXPECT_EQ(1, scores[12]);
+  EXPECT_EQ(0, DetectKeyPeriod("a"));
+}
+
+}  // namespace
+}  // namespace cryptopals
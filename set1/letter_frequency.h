@@ -1,12 +1,16 @@
 #ifndef CRYPTOPALS_UTIL_LETTER_FREQUENCY_H_
 #define CRYPTOPALS_UTIL_LETTER_FREQUENCY_H_
 
+#include <array>
 #include <string_view>
 
 namespace cryptopals {
 
 double CharFreq(unsigned char ch);
 
+// CharFreq of every byte value, indexed by the byte.
+const std::array<double, 256>& CharFreqTable();
+
 double MessageAvgFreq(std::string_view message);
 
 }  // namespace cryptopals
@@ -0,0 +1,90 @@
+// Build-time generator for the tables compiled into letter_freq and
+// ngram_score. Usage: letter_frequency_gen unigram|bigram <corpus> <out.inc>
+//
+// unigram: one initializer entry per byte value, its relative frequency in
+// the corpus or 0 if it does not occur. Values are printed as hexadecimal
+// floating point literals so the table is bit-exact.
+//
+// bigram: 65536 int16 entries indexed by (first << 8 | second), each the
+// log2 of P(second | first) in units of 1/256 bit. Unseen pairs get additive
+// smoothing, so every entry is finite.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr double kBigramScale = 256;  // must match ngram_score.h
+constexpr double kSmoothing = 0.01;   // pseudo count of every pair
+
+void WriteUnigrams(const std::string& text, FILE* out) {
+  double counts[256] = {};
+  for (const unsigned char c : text) {
+    counts[c] += 1.0;
+  }
+  for (int c = 0; c < 256; c++) {
+    double freq = counts[c] / static_cast<double>(text.size());
+    std::fprintf(out, "%a,  // %d\n", freq, c);
+  }
+}
+
+void WriteBigrams(const std::string& text, FILE* out) {
+  std::vector<double> pairs(65536), firsts(256);
+  for (size_t i = 0; i + 1 < text.size(); i++) {
+    auto first = static_cast<uint8_t>(text[i]);
+    auto second = static_cast<uint8_t>(text[i + 1]);
+    pairs[first << 8u | second] += 1.0;
+    firsts[first] += 1.0;
+  }
+  for (int first = 0; first < 256; first++) {
+    for (int second = 0; second < 256; second++) {
+      double p = (pairs[first << 8 | second] + kSmoothing) /
+                 (firsts[first] + 256 * kSmoothing);
+      long value = std::lround(std::log2(p) * kBigramScale);
+      std::fprintf(out, "%ld,%s", value, second % 16 == 15 ? "\n" : " ");
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 4 || (std::strcmp(argv[1], "unigram") != 0 &&
+                    std::strcmp(argv[1], "bigram") != 0)) {
+    std::cerr << "Usage: " << argv[0]
+              << " unigram|bigram <corpus> <output.inc>\n";
+    return 1;
+  }
+  std::ifstream file(argv[2], std::ios::in | std::ios::binary);
+  if (!file.is_open()) {
+    std::cerr << "Cannot open file " << argv[2] << "\n";
+    return 1;
+  }
+  std::stringstream ss;
+  ss << file.rdbuf();
+  std::string text = ss.str();
+  if (text.size() < 2) {
+    std::cerr << "Corpus too short " << argv[2] << "\n";
+    return 1;
+  }
+
+  FILE* out = std::fopen(argv[3], "w");
+  if (out == nullptr) {
+    std::cerr << "Cannot write file " << argv[3] << "\n";
+    return 1;
+  }
+  std::fprintf(out, "// Generated by letter_frequency_gen, do not edit.\n");
+  if (std::strcmp(argv[1], "unigram") == 0) {
+    WriteUnigrams(text, out);
+  } else {
+    WriteBigrams(text, out);
+  }
+  return std::fclose(out) == 0 ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#include "ngram_score.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CRYPTOPALS_X86 1
+#endif
+
+namespace cryptopals {
+
+namespace {
+
+// Two trailing entries of padding: the gather loads 32 bits per index.
+constexpr int16_t kBigramTable[65536 + 2] = {
+#include "bigram_table.inc"
+};
+
+using BigramKernel = int64_t (*)(const uint8_t*, size_t);
+
+int64_t BigramScalar(const uint8_t* text, size_t size) {
+  int64_t total = 0;
+  for (size_t i = 0; i + 1 < size; i++) {
+    total += kBigramTable[text[i] << 8u | text[i + 1]];
+  }
+  return total;
+}
+
+#ifdef CRYPTOPALS_X86
+// Builds the 16 indices text[i] << 8 | text[i + 1] from two overlapping loads,
+// then gathers 8 table entries at a time.
+__attribute__((target("avx2"))) int64_t BigramAvx2(const uint8_t* text,
+                                                   size_t size) {
+  const auto* table = reinterpret_cast<const int*>(kBigramTable);
+  __m256i sum = _mm256_setzero_si256();
+  size_t i = 0;
+  // Positions i .. i + 15 read bytes up to i + 16.
+  for (; i + 17 <= size; i += 16) {
+    __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+    __m128i second =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + 1));
+    // 16-bit indices: first << 8 | second
+    __m128i lo = _mm_unpacklo_epi8(second, first);
+    __m128i hi = _mm_unpackhi_epi8(second, first);
+    __m256i index_lo = _mm256_cvtepu16_epi32(lo);
+    __m256i index_hi = _mm256_cvtepu16_epi32(hi);
+    // Gather 32 bits at byte offset 2 * index, keep the low int16.
+    __m256i value_lo = _mm256_i32gather_epi32(table, index_lo, 2);
+    __m256i value_hi = _mm256_i32gather_epi32(table, index_hi, 2);
+    value_lo = _mm256_srai_epi32(_mm256_slli_epi32(value_lo, 16), 16);
+    value_hi = _mm256_srai_epi32(_mm256_slli_epi32(value_hi, 16), 16);
+    // 32-bit lanes can take 2^31 / (16 * 2^15) = 4096 steps before they
+    // could overflow, widen to 64 bits every step instead of tracking that.
+    __m256i step = _mm256_add_epi32(value_lo, value_hi);
+    sum = _mm256_add_epi64(
+        sum, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(step)));
+    sum = _mm256_add_epi64(
+        sum, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(step, 1)));
+  }
+  int64_t total = _mm256_extract_epi64(sum, 0) + _mm256_extract_epi64(sum, 1) +
+                  _mm256_extract_epi64(sum, 2) + _mm256_extract_epi64(sum, 3);
+  return total + BigramScalar(text + i, size - i);
+}
+#endif
+
+BigramKernel SelectKernel() {
+#ifdef CRYPTOPALS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return BigramAvx2;
+  }
+#endif
+  return BigramScalar;
+}
+
+}  // namespace
+
+int16_t BigramLogProb(unsigned char first, unsigned char second) {
+  return kBigramTable[first << 8u | second];
+}
+
+int64_t TextBigramLogProb(std::string_view text) {
+  static const BigramKernel kernel = SelectKernel();
+  return kernel(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+}
+
+double BigramScore(std::string_view text) {
+  if (text.size() < 2) {
+    return 0;
+  }
+  return static_cast<double>(TextBigramLogProb(text)) /
+         (static_cast<double>(text.size() - 1) * kBigramScale);
+}
+
+}  // namespace cryptopals
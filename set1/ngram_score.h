@@ -0,0 +1,27 @@
+#ifndef CRYPTOPALS_SET1_NGRAM_SCORE_H_
+#define CRYPTOPALS_SET1_NGRAM_SCORE_H_
+
+#include <cstdint>
+#include <string_view>
+
+namespace cryptopals {
+
+// Bigram language model trained on 1984.txt at build time. The table holds
+// log2 P(second | first) as int16 in units of 1/kBigramScale bit, 128 KiB
+// indexed by (first << 8 | second), so it stays resident in L2.
+constexpr int kBigramScale = 256;
+
+int16_t BigramLogProb(unsigned char first, unsigned char second);
+
+// Sum of the bigram log-probabilities of all adjacent byte pairs in `text`,
+// in units of 1/kBigramScale bit. Uses AVX2 gathers, 16 positions per step,
+// when the CPU supports them.
+int64_t TextBigramLogProb(std::string_view text);
+
+// TextBigramLogProb averaged per pair, in bits. Higher is more English-like;
+// returns 0 for texts shorter than two bytes.
+double BigramScore(std::string_view text);
+
+}  // namespace cryptopals
+
+#endif  // CRYPTOPALS_SET1_NGRAM_SCORE_H_
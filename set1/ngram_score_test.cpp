@@ -0,0 +1,47 @@
+#include "ngram_score.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace cryptopals {
+namespace {
+
+constexpr char kText[] =
+    "It was a bright cold day in April, and the clocks were striking "
+    "thirteen. Winston Smith, his chin nuzzled into his breast in an effort "
+    "to escape the vile wind, slipped quickly through the glass doors of "
+    "Victory Mansions, though not quickly enough to prevent a swirl of "
+    "gritty dust from entering along with him.";
+
+TEST(NgramScoreTest, MatchesPairwiseSum) {
+  std::string text = kText;
+  // Bytes outside ASCII as well
+  for (int i = 0; i < 256; i++) text.push_back(static_cast<char>(i));
+  for (size_t size = 0; size <= text.size(); size++) {
+    std::string_view prefix = std::string_view(text).substr(0, size);
+    int64_t expected = 0;
+    for (size_t i = 0; i + 1 < prefix.size(); i++) {
+      expected += BigramLogProb(prefix[i], prefix[i + 1]);
+    }
+    ASSERT_EQ(expected, TextBigramLogProb(prefix)) << size;
+  }
+}
+
+TEST(NgramScoreTest, PrefersEnglish) {
+  EXPECT_GT(BigramLogProb('t', 'h'), BigramLogProb('t', 'q'));
+  EXPECT_GT(BigramLogProb('q', 'u'), BigramLogProb('q', 'e'));
+  std::string text = kText;
+  double score = BigramScore(text);
+  // A single-byte XOR of English scores far lower, even when it keeps most
+  // letters printable.
+  for (char key : {' ', '\x01', 'A'}) {
+    std::string xored = text;
+    for (auto& ch : xored) ch ^= key;
+    EXPECT_LT(BigramScore(xored), score - 2) << static_cast<int>(key);
+  }
+  EXPECT_EQ(0, BigramScore("a"));
+}
+
+}  // namespace
+}  // namespace cryptopals
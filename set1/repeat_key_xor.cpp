@@ -2,9 +2,17 @@
 
 #include <algorithm>
 #include <functional>
+#include <limits>
 #include <queue>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
+#include "../util/parallel.h"
+#include "fixed_xor.h"
+#include "hamming_distance.h"
+#include "key_period.h"
+#include "ngram_score.h"
 #include "single_byte_xor_cipher.h"
 
 namespace cryptopals {
@@ -16,17 +24,13 @@ using min_heap = std::priority_queue<T, std::vector<T>, std::greater<T>>;
 
 constexpr uint8_t kMinKeySize = 2;
 constexpr uint8_t kMaxKeySize = 40;
-constexpr uint8_t kMaxBlobsCount = 4;
 constexpr uint8_t kKeySizeCandidateCount = 3;
-
-uint8_t CountSetBits(uint8_t n) {
-  uint8_t count = 0;
-  while (n) {
-    count += n & 1u;
-    n >>= 1u;
-  }
-  return count;
-}
+// The expanded key holds whole key periods and is at least this long, large
+// enough to amortize the kernel call and small enough to stay in L1.
+constexpr size_t kMinKeyPatternSize = 4096;
+// Rows per cache block when transposing ciphertext into key columns.
+constexpr size_t kTransposeRows = 64;
+constexpr size_t kColumnsPerTask = 4;
 
 struct KeySize {
   uint8_t size;
@@ -52,47 +56,72 @@ min_heap<KeySize> GuessKeySize(std::string_view ciphertext) {
     if (ciphertext.size() / s < 2) {
       break;
     }
-    // split the ciphertext into blobs of size `s`
-    std::vector<std::string> blobs(
-        std::max(static_cast<uint8_t>(ciphertext.size() / s), kMaxBlobsCount));
-    for (int i = 0; i < blobs.size(); i++) {
-      blobs[i] = ciphertext.substr(i * s, s);
-    }
-    // calculate the average hamming dist between blobs
-    uint64_t total_dist = 0;
-    for (int i = 0; i < blobs.size() - 1; i++) {
-      total_dist += GetHammingDistance(blobs[i], blobs[i + 1]);
-    }
+    // Hamming dist between all adjacent blobs of size `s`
+    size_t pairs = ciphertext.size() / s - 1;
+    uint64_t total_dist = TotalAdjacentBlockDistance(ciphertext, s);
     // `avg_dist` is avg dist between two blobs, KeySize.hamming_dist is the
     // average of distance PER BYTE, so we need to divide by key size `s`
     // again.
     double avg_dist =
-        static_cast<double>(total_dist) / static_cast<double>(blobs.size() - 1);
+        static_cast<double>(total_dist) / static_cast<double>(pairs);
     output.emplace(KeySize{s, avg_dist / s});
   }
   return output;
 }
 
+// Column-major copy of `ciphertext` for a key of `key_size` bytes: column c,
+// i.e. bytes c, c + key_size, c + 2 * key_size, ..., is stored contiguously
+// at data[offsets[c], offsets[c + 1]).
+struct Columns {
+  std::string data;
+  std::vector<size_t> offsets;
+
+  std::string_view Column(size_t c) const {
+    return std::string_view(data).substr(offsets[c],
+                                         offsets[c + 1] - offsets[c]);
+  }
+};
+
+Columns Transpose(std::string_view ciphertext, size_t key_size) {
+  Columns columns;
+  columns.data.resize(ciphertext.size());
+  columns.offsets.resize(key_size + 1);
+  for (size_t c = 0; c < key_size; c++) {
+    size_t column_size =
+        c < ciphertext.size()
+            ? (ciphertext.size() - c + key_size - 1) / key_size
+            : 0;
+    columns.offsets[c + 1] = columns.offsets[c] + column_size;
+  }
+  // A block of rows (rows are key_size bytes) is read once per column while
+  // it stays in cache, and each column receives a contiguous run per block.
+  const size_t rows = (ciphertext.size() + key_size - 1) / key_size;
+  for (size_t row_begin = 0; row_begin < rows; row_begin += kTransposeRows) {
+    size_t row_end = std::min(rows, row_begin + kTransposeRows);
+    for (size_t c = 0; c < key_size; c++) {
+      char* out = &columns.data[columns.offsets[c]];
+      for (size_t r = row_begin; r < row_end; r++) {
+        size_t i = r * key_size + c;
+        if (i >= ciphertext.size()) break;
+        out[r] = ciphertext[i];
+      }
+    }
+  }
+  return columns;
+}
+
 }  // namespace
 
 uint32_t GetHammingDistance(std::string_view str1, std::string_view str2) {
-  uint32_t dist = 0;
-  for (int i = 0; i < str1.size(); i++) {
-    uint8_t xor_result =
-        static_cast<uint8_t>(str1[i]) ^ static_cast<uint8_t>(str2[i]);
-    dist += CountSetBits(xor_result);
-  }
-  return dist;
+  return static_cast<uint32_t>(HammingDistance(str1, str2));
 }
 
 std::string RepeatKeyXorEncode(std::string_view plaintext,
                                std::string_view key) {
-  std::string output;
-  output.resize(plaintext.size());
-  for (int i = 0; i < plaintext.size(); i++) {
-    output[i] = static_cast<uint8_t>(plaintext[i]) ^
-                static_cast<uint8_t>(key[i % key.size()]);
-  }
+  std::string output(plaintext.size(), 0);
+  RepeatKeyXor(reinterpret_cast<uint8_t*>(output.data()),
+               reinterpret_cast<const uint8_t*>(plaintext.data()),
+               plaintext.size(), key);
   return output;
 }
 
@@ -101,33 +130,116 @@ std::string RepeatKeyXorDecode(std::string_view ciphertext,
   return RepeatKeyXorEncode(ciphertext, key);
 }
 
-BreakRepeatKeyXorOutput BreakRepeatKeyXor(std::string_view ciphertext) {
+void RepeatKeyXorInPlace(std::string* buffer, std::string_view key) {
+  auto* data = reinterpret_cast<uint8_t*>(buffer->data());
+  RepeatKeyXor(data, data, buffer->size(), key);
+}
+
+void RepeatKeyXor(uint8_t* dst, const uint8_t* src, size_t size,
+                  std::string_view key, size_t key_offset) {
+  if (key.empty()) {
+    throw std::invalid_argument("empty key");
+  }
+  if (size == 0) {
+    return;
+  }
+  // Rotate the key so the pattern starts at `key_offset`, then repeat it.
+  // Every pattern-sized step of the input starts at the same key phase.
+  size_t periods = (kMinKeyPatternSize + key.size() - 1) / key.size();
+  size_t pattern_size = std::min(periods * key.size(), size);
+  std::string pattern;
+  pattern.reserve(pattern_size + key.size());
+  key_offset %= key.size();
+  pattern.append(key.substr(key_offset)).append(key.substr(0, key_offset));
+  while (pattern.size() < pattern_size) {
+    pattern.append(pattern.data(),
+                   std::min(pattern.size(), pattern_size - pattern.size()));
+  }
+  const auto* pattern_data = reinterpret_cast<const uint8_t*>(pattern.data());
+  for (size_t i = 0; i < size; i += pattern_size) {
+    XorBytes(dst + i, src + i, pattern_data, std::min(pattern_size, size - i));
+  }
+}
+
+BreakRepeatKeyXorOutput BreakRepeatKeyXor(std::string_view ciphertext,
+                                          unsigned threads) {
   BreakRepeatKeyXorOutput best;
   best.score = std::numeric_limits<double>::lowest();
+  // The autocorrelation estimate first, it also covers keys longer than
+  // kMaxKeySize, then the best blob-based guesses.
+  std::vector<size_t> key_sizes;
+  KeyPeriodOptions period_options;
+  period_options.threads = threads;
+  if (size_t period = DetectKeyPeriod(ciphertext, period_options);
+      period > 0) {
+    key_sizes.push_back(period);
+  }
   auto key_guesses = GuessKeySize(ciphertext);
-  int max_tries = std::min(key_guesses.size(), (size_t)kKeySizeCandidateCount);
-  for (int tries = 0; tries < max_tries; tries++, key_guesses.pop()) {
-    double total_score = 0;
-    std::string key;
-    auto key_guess = key_guesses.top();
-    std::vector<std::string> single_key_ciphertexts;
-    single_key_ciphertexts.resize(key_guess.size);
-    for (int i = 0; i < ciphertext.size(); i++) {
-      single_key_ciphertexts[i % key_guess.size] += ciphertext[i];
+  for (int tries = 0; tries < kKeySizeCandidateCount && !key_guesses.empty();
+       tries++, key_guesses.pop()) {
+    size_t size = key_guesses.top().size;
+    if (std::find(key_sizes.begin(), key_sizes.end(), size) ==
+        key_sizes.end()) {
+      key_sizes.push_back(size);
     }
-    for (const auto& single_key_ciphertext : single_key_ciphertexts) {
-      SingleByteXorPlaintext plaintext =
-          DecodeSingleByteXorCipher(single_key_ciphertext);
-      key += plaintext.key;
-      total_score += plaintext.score * plaintext.plaintext.size();
-    }
-    double avg_score = total_score / ciphertext.size();
-    if (avg_score > best.score) {
-      best.key = key;
-      best.score = avg_score;
+  }
+
+  // Transpose for every candidate size, then solve all (size, column) pairs
+  // as one flat list of tasks. Every task writes its own key byte, so the
+  // result does not depend on scheduling.
+  std::vector<Columns> columns(key_sizes.size());
+  std::vector<std::string> keys(key_sizes.size());
+  std::vector<size_t> first_task(key_sizes.size() + 1, 0);
+  for (size_t s = 0; s < key_sizes.size(); s++) {
+    keys[s].resize(key_sizes[s]);
+    first_task[s + 1] = first_task[s] + key_sizes[s];
+  }
+  util::ParallelFor(
+      key_sizes.size(), 1,
+      [&](size_t begin, size_t end) {
+        for (size_t s = begin; s < end; s++) {
+          columns[s] = Transpose(ciphertext, key_sizes[s]);
+        }
+      },
+      threads);
+  util::ParallelFor(
+      first_task.back(), kColumnsPerTask,
+      [&](size_t begin, size_t end) {
+        size_t s = std::upper_bound(first_task.begin(), first_task.end(),
+                                    begin) -
+                   first_task.begin() - 1;
+        for (size_t task = begin; task < end; task++) {
+          while (task >= first_task[s + 1]) s++;
+          size_t c = task - first_task[s];
+          std::string_view column = columns[s].Column(c);
+          double score;
+          keys[s][c] = static_cast<char>(BestSingleByteXorKey(
+              BuildByteHistogram(column), column.size(), &score));
+        }
+      },
+      threads);
+
+  // Columns are solved independently on unigrams; the bigram model also
+  // sees which columns fit together, so it decides between key sizes. Ties
+  // go to the earlier candidate.
+  std::vector<std::string> plaintexts(key_sizes.size());
+  std::vector<double> scores(key_sizes.size());
+  util::ParallelFor(
+      key_sizes.size(), 1,
+      [&](size_t begin, size_t end) {
+        for (size_t s = begin; s < end; s++) {
+          plaintexts[s] = RepeatKeyXorDecode(ciphertext, keys[s]);
+          scores[s] = BigramScore(plaintexts[s]);
+        }
+      },
+      threads);
+  for (size_t s = 0; s < key_sizes.size(); s++) {
+    if (scores[s] > best.score) {
+      best.key = std::move(keys[s]);
+      best.plaintext = std::move(plaintexts[s]);
+      best.score = scores[s];
     }
   }
-  best.plaintext = RepeatKeyXorDecode(ciphertext, best.key);
   return best;
 }
 
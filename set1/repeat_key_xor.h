@@ -1,6 +1,8 @@
 #ifndef CRYPTOPALS_SET1_REPEAT_KEY_XOR_H_
 #define CRYPTOPALS_SET1_REPEAT_KEY_XOR_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <string_view>
 
@@ -9,7 +11,7 @@ namespace cryptopals {
 struct BreakRepeatKeyXorOutput {
   std::string key;
   std::string plaintext;
-  double score;  // averaged score per character
+  double score;  // BigramScore of the plaintext
 };
 
 uint32_t GetHammingDistance(std::string_view str1, std::string_view str2);
@@ -20,7 +22,21 @@ std::string RepeatKeyXorEncode(std::string_view plaintext,
 std::string RepeatKeyXorDecode(std::string_view ciphertext,
                                std::string_view key);
 
-BreakRepeatKeyXorOutput BreakRepeatKeyXor(std::string_view ciphertext);
+// Same as RepeatKeyXorEncode, but XORs `buffer` in place.
+void RepeatKeyXorInPlace(std::string* buffer, std::string_view key);
+
+// dst[i] = src[i] ^ key[(key_offset + i) % key.size()] for i < size, where
+// `dst` may be `src`. `key_offset` lets a long input be processed in chunks.
+// The key is expanded once into a pattern of whole key periods, so the XOR
+// runs on the vector kernel of FixedXor without a division per byte.
+void RepeatKeyXor(uint8_t* dst, const uint8_t* src, size_t size,
+                  std::string_view key, size_t key_offset = 0);
+
+// Candidate key sizes are transposed into key columns, and all columns of
+// all candidates are solved concurrently on `threads` workers (0 means all
+// cores). The result does not depend on the thread count.
+BreakRepeatKeyXorOutput BreakRepeatKeyXor(std::string_view ciphertext,
+                                          unsigned threads = 0);
 
 }  // namespace cryptopals
 
@@ -1,6 +1,8 @@
 #include "repeat_key_xor.h"
 
+#include <algorithm>
 #include <fstream>
+#include <stdexcept>
 
 #include "absl/strings/escaping.h"
 #include "gtest/gtest.h"
@@ -21,6 +23,36 @@ TEST(RepeatKeyXorTest, RepeatKeyXorEncode) {
       absl::BytesToHexString(ciphertext));
 }
 
+TEST(RepeatKeyXorTest, LongInputAndOffsets) {
+  std::string plaintext;
+  for (int i = 0; i < 10000; i++) {
+    plaintext.push_back(static_cast<char>(i * 31 + i / 7));
+  }
+  // Key lengths that divide the pattern size, and ones that don't
+  for (std::string key : {"k", "ICE", "0123456789abcdef", "Terminator X"}) {
+    std::string expected;
+    for (size_t i = 0; i < plaintext.size(); i++) {
+      expected.push_back(static_cast<char>(plaintext[i] ^ key[i % key.size()]));
+    }
+    EXPECT_EQ(expected, RepeatKeyXorEncode(plaintext, key));
+
+    std::string buffer = plaintext;
+    RepeatKeyXorInPlace(&buffer, key);
+    EXPECT_EQ(expected, buffer);
+
+    // Chunks of odd sizes, keeping the key phase across them
+    buffer = plaintext;
+    auto* data = reinterpret_cast<uint8_t*>(buffer.data());
+    for (size_t begin = 0, chunk = 1; begin < buffer.size();
+         begin += chunk, chunk = chunk * 3 + 1) {
+      chunk = std::min(chunk, buffer.size() - begin);
+      RepeatKeyXor(data + begin, data + begin, chunk, key, begin);
+    }
+    EXPECT_EQ(expected, buffer);
+  }
+  EXPECT_THROW(RepeatKeyXorEncode(plaintext, ""), std::invalid_argument);
+}
+
 TEST(RepeatKeyXorTest, GetHammingDistance) {
   std::string str1 = "this is a test";
   std::string str2 = "wokka wokka!!!";
@@ -42,6 +74,13 @@ TEST(RepeatKeyXorTest, BreakRepeatKeyXor) {
   EXPECT_EQ("I'm back and I'm ringin' the bell ",
             output.plaintext.substr(0, output.plaintext.find('\n')));
   EXPECT_EQ("Terminator X: Bring the noise", output.key);
+
+  for (unsigned threads : {1, 3, 8}) {
+    BreakRepeatKeyXorOutput other = BreakRepeatKeyXor(ciphertext, threads);
+    EXPECT_EQ(output.key, other.key);
+    EXPECT_EQ(output.plaintext, other.plaintext);
+    EXPECT_EQ(output.score, other.score);
+  }
 }
 
 }  // namespace
@@ -1,38 +1,240 @@
 #include "single_byte_xor_cipher.h"
 
-#include "fixed_xor.h"
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+#include "../util/codec.h"
+#include "../util/mapped_file.h"
+#include "../util/parallel.h"
 #include "letter_frequency.h"
 
 namespace cryptopals {
 
-SingleByteXorPlaintext DecodeSingleByteXorCipher(std::string_view ciphertext) {
+namespace {
+
+std::string XorWithByte(std::string_view ciphertext, uint8_t key) {
+  std::string plaintext(ciphertext);
+  for (auto& ch : plaintext) {
+    ch = static_cast<char>(static_cast<uint8_t>(ch) ^ key);
+  }
+  return plaintext;
+}
+
+constexpr size_t kLinesPerTask = 1024;
+constexpr size_t kLinesPerFileBatch = 1 << 16;
+
+struct Candidate {
+  double score;
+  size_t pos;
+  uint8_t key;
+};
+
+// Higher score first, then the earlier line. A total order, so the merged
+// result does not depend on how lines were split across threads.
+template <class T>
+bool Better(const T& a, const T& b) {
+  return a.score != b.score ? a.score > b.score : a.pos < b.pos;
+}
+
+// Keeps the k best candidates pushed so far.
+class TopK {
+ public:
+  explicit TopK(size_t k) : k_(k) { heap_.reserve(k); }
+
+  void Push(const Candidate& candidate) {
+    // With Better as the ordering, the heap front is the worst candidate.
+    if (heap_.size() < k_) {
+      heap_.push_back(candidate);
+      std::push_heap(heap_.begin(), heap_.end(), Better<Candidate>);
+    } else if (k_ > 0 && Better(candidate, heap_.front())) {
+      std::pop_heap(heap_.begin(), heap_.end(), Better<Candidate>);
+      heap_.back() = candidate;
+      std::push_heap(heap_.begin(), heap_.end(), Better<Candidate>);
+    }
+  }
+
+  const std::vector<Candidate>& Items() const { return heap_; }
+
+  std::vector<Candidate> Sorted() const {
+    std::vector<Candidate> sorted = heap_;
+    std::sort(sorted.begin(), sorted.end(), Better<Candidate>);
+    return sorted;
+  }
+
+ private:
+  size_t k_;
+  std::vector<Candidate> heap_;
+};
+
+// Scores lines 0 .. count - 1, `line_at(i)` returns line i. `pos` of the
+// results is offset by `first_pos`.
+template <class LineAt>
+std::vector<Candidate> ScoreLines(size_t count, const LineAt& line_at,
+                                  size_t first_pos, size_t k,
+                                  unsigned threads) {
+  TopK top(k);
+  std::mutex mu;
+  util::ParallelFor(
+      count, kLinesPerTask,
+      [&](size_t begin, size_t end) {
+        TopK local(k);
+        for (size_t i = begin; i < end; i++) {
+          std::string_view line = line_at(i);
+          Candidate candidate;
+          candidate.key = BestSingleByteXorKey(BuildByteHistogram(line),
+                                               line.size(), &candidate.score);
+          candidate.pos = first_pos + i;
+          local.Push(candidate);
+        }
+        std::lock_guard<std::mutex> lock(mu);
+        for (const auto& candidate : local.Items()) top.Push(candidate);
+      },
+      threads);
+  return top.Sorted();
+}
+
+SingleByteXorPlaintext ToPlaintext(const Candidate& candidate,
+                                   std::string_view line) {
   SingleByteXorPlaintext result;
-  result.score = std::numeric_limits<double>::lowest();
+  result.key = candidate.key;
+  result.plaintext = XorWithByte(line, candidate.key);
+  result.score = candidate.score;
+  result.pos = candidate.pos;
+  return result;
+}
+
+}  // namespace
+
+ByteHistogram BuildByteHistogram(std::string_view data) {
+  // Four interleaved tables, so runs of the same byte do not serialize on
+  // a single counter.
+  uint32_t counts[4][256] = {};
+  const auto* bytes = reinterpret_cast<const uint8_t*>(data.data());
+  size_t i = 0;
+  for (; i + 4 <= data.size(); i += 4) {
+    counts[0][bytes[i]]++;
+    counts[1][bytes[i + 1]]++;
+    counts[2][bytes[i + 2]]++;
+    counts[3][bytes[i + 3]]++;
+  }
+  for (; i < data.size(); i++) {
+    counts[0][bytes[i]]++;
+  }
+  ByteHistogram histogram;
+  for (int b = 0; b < 256; b++) {
+    histogram[b] = counts[0][b] + counts[1][b] + counts[2][b] + counts[3][b];
+  }
+  return histogram;
+}
+
+uint8_t BestSingleByteXorKey(const ByteHistogram& histogram, size_t size,
+                             double* score) {
+  if (size == 0) {
+    *score = 0;
+    return 0;
+  }
+  // Only the byte values present matter, usually a small fraction of 256.
+  uint8_t present[256];
+  double weight[256];
+  int present_count = 0;
+  for (int b = 0; b < 256; b++) {
+    if (histogram[b] != 0) {
+      present[present_count] = static_cast<uint8_t>(b);
+      weight[present_count++] = histogram[b];
+    }
+  }
+  const std::array<double, 256>& freq = CharFreqTable();
+  double best_score = std::numeric_limits<double>::lowest();
+  uint8_t best_key = 0;
   for (uint32_t k = 0; k <= 0xff; k++) {
-    std::string candidate =
-        FixedXor(ciphertext, std::string(ciphertext.size(), k));
-    double score = MessageAvgFreq(candidate);
-    if (score > result.score) {
-      result.score = score;
-      result.key = k;
-      result.plaintext = candidate;
+    double total = 0;
+    for (int i = 0; i < present_count; i++) {
+      total += weight[i] * freq[present[i] ^ k];
+    }
+    if (total > best_score) {
+      best_score = total;
+      best_key = k;
     }
   }
+  *score = best_score / static_cast<double>(size);
+  return best_key;
+}
+
+SingleByteXorPlaintext DecodeSingleByteXorCipher(std::string_view ciphertext) {
+  SingleByteXorPlaintext result;
+  result.key = BestSingleByteXorKey(BuildByteHistogram(ciphertext),
+                                    ciphertext.size(), &result.score);
+  result.plaintext = XorWithByte(ciphertext, result.key);
   return result;
 }
 
 SingleByteXorPlaintext DetectSingleByteXorCipher(
-    std::vector<std::string> ciphertexts) {
-  SingleByteXorPlaintext best, current;
-  best.score = std::numeric_limits<double>::lowest();
-  for (int i = 0; i < ciphertexts.size(); i++) {
-    current = DecodeSingleByteXorCipher(ciphertexts[i]);
-    if (current.score > best.score) {
-      best = current;
-      best.pos = i;
+    const std::vector<std::string>& ciphertexts) {
+  auto line_at = [&ciphertexts](size_t i) -> std::string_view {
+    return ciphertexts[i];
+  };
+  auto best = ScoreLines(ciphertexts.size(), line_at, 0, /*k=*/1, 0);
+  if (best.empty()) {
+    SingleByteXorPlaintext none{};
+    none.score = std::numeric_limits<double>::lowest();
+    return none;
+  }
+  // Only the winner is decrypted.
+  return ToPlaintext(best[0], ciphertexts[best[0].pos]);
+}
+
+std::vector<SingleByteXorPlaintext> DetectSingleByteXorCipherTopK(
+    std::string_view buffer, const std::vector<size_t>& offsets, size_t k,
+    unsigned threads) {
+  if (offsets.size() < 2) {
+    return {};
+  }
+  auto line_at = [buffer, &offsets](size_t i) {
+    return buffer.substr(offsets[i], offsets[i + 1] - offsets[i]);
+  };
+  std::vector<SingleByteXorPlaintext> results;
+  for (const auto& candidate :
+       ScoreLines(offsets.size() - 1, line_at, 0, k, threads)) {
+    results.push_back(ToPlaintext(candidate, line_at(candidate.pos)));
+  }
+  return results;
+}
+
+std::vector<SingleByteXorPlaintext> DetectSingleByteXorCipherTopKInHexFile(
+    const std::string& path, size_t k, unsigned threads) {
+  const util::MappedFile file = util::MappedFile::Open(path);
+  file.AdviseSequential();
+  util::Lines lines(file.data());
+  auto line = lines.begin();
+  std::vector<SingleByteXorPlaintext> results;
+  std::string buffer;
+  std::vector<size_t> offsets;
+  size_t first_pos = 0;
+  while (line != lines.end()) {
+    // Decode the next batch of lines into one flat buffer.
+    buffer.clear();
+    offsets.assign(1, 0);
+    for (; line != lines.end() && offsets.size() <= kLinesPerFileBatch;
+         ++line) {
+      if (!util::HexDecodeAppend(*line, &buffer)) {
+        throw std::runtime_error("Invalid hex line in " + path);
+      }
+      offsets.push_back(buffer.size());
+    }
+    // Winners of this batch are decrypted now, the buffer is reused after.
+    for (auto& result : DetectSingleByteXorCipherTopK(buffer, offsets, k,
+                                                      threads)) {
+      result.pos += first_pos;
+      results.push_back(std::move(result));
     }
+    std::sort(results.begin(), results.end(),
+              Better<SingleByteXorPlaintext>);
+    results.resize(std::min(results.size(), k));
+    first_pos += offsets.size() - 1;
   }
-  return best;
+  return results;
 }
 
-}  // namespace cryptopals
\ No newline at end of file
+}  // namespace cryptopals
@@ -1,6 +1,7 @@
 #ifndef CRYPTOPALS_SET1_SINGLE_BYTE_XOR_CIPHER_H_
 #define CRYPTOPALS_SET1_SINGLE_BYTE_XOR_CIPHER_H_
 
+#include <array>
 #include <cstdlib>
 #include <string>
 #include <string_view>
@@ -15,10 +16,42 @@ struct SingleByteXorPlaintext {
   size_t pos;    // only used in DetectSingleByteXorCipher
 };
 
+// Occurrences of each byte value.
+using ByteHistogram = std::array<uint32_t, 256>;
+
+ByteHistogram BuildByteHistogram(std::string_view data);
+
+// Decrypting with key k turns every byte b into b ^ k, so the score of k is
+// sum(histogram[b] * CharFreq(b ^ k)) / size: all 256 keys are scored from
+// the histogram alone, without touching the ciphertext again. Returns the
+// best key (the smallest one on ties) and writes its averaged score to
+// `score`. `size` is the number of bytes counted in `histogram`.
+uint8_t BestSingleByteXorKey(const ByteHistogram& histogram, size_t size,
+                             double* score);
+
 SingleByteXorPlaintext DecodeSingleByteXorCipher(std::string_view ciphertext);
 
 SingleByteXorPlaintext DetectSingleByteXorCipher(
-    std::vector<std::string> ciphertexts);
+    const std::vector<std::string>& ciphertexts);
+
+// The `k` lines most likely to be single-byte XOR encrypted English, best
+// first (ties go to the earlier line), with `pos` set to the line index.
+// Lines are scored from their histograms on `threads` workers (0 means all
+// cores), each keeping its own top-k which are merged at the end; only the
+// k winners are decrypted.
+//
+// Line i is buffer[offsets[i], offsets[i + 1]), `offsets` holds one more
+// entry than there are lines.
+std::vector<SingleByteXorPlaintext> DetectSingleByteXorCipherTopK(
+    std::string_view buffer, const std::vector<size_t>& offsets, size_t k,
+    unsigned threads = 0);
+
+// Same as above over a file of hex encoded lines, as in challenge 4. The file
+// is mapped and decoded in batches of lines, so its size is not bounded by
+// memory.
+// Throws std::runtime_error if the file cannot be read or a line is not hex.
+std::vector<SingleByteXorPlaintext> DetectSingleByteXorCipherTopKInHexFile(
+    const std::string& path, size_t k, unsigned threads = 0);
 
 }  // namespace cryptopals
 
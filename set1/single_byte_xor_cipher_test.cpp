@@ -1,9 +1,12 @@
 #include "single_byte_xor_cipher.h"
 
 #include <fstream>
+#include <limits>
+#include <stdexcept>
 
 #include "absl/strings/escaping.h"
 #include "gtest/gtest.h"
+#include "letter_frequency.h"
 
 namespace cryptopals {
 namespace {
@@ -16,6 +19,29 @@ TEST(SingleByteXorCipherTest, DecodeSingleByteXorCipher) {
   EXPECT_EQ('X', result.key);
 }
 
+TEST(SingleByteXorCipherTest, HistogramScoreMatchesMessageScore) {
+  std::string ciphertext = absl::HexStringToBytes(
+      "1b37373331363f78151b7f2b783431333d78397828372d363c78373e783a393b3736");
+  ByteHistogram histogram = BuildByteHistogram(ciphertext);
+  double score;
+  uint8_t key = BestSingleByteXorKey(histogram, ciphertext.size(), &score);
+  // Brute force over all keys
+  double best_score = std::numeric_limits<double>::lowest();
+  uint8_t best_key = 0;
+  for (uint32_t k = 0; k <= 0xff; k++) {
+    std::string candidate = ciphertext;
+    for (auto& ch : candidate) ch = static_cast<char>(ch ^ k);
+    double candidate_score = MessageAvgFreq(candidate);
+    if (candidate_score > best_score) {
+      best_score = candidate_score;
+      best_key = k;
+    }
+  }
+  EXPECT_EQ(best_key, key);
+  EXPECT_NEAR(best_score, score, 1e-12);
+  EXPECT_EQ(5, histogram['7']);
+}
+
 TEST(SingleByteXorCipherTest, DetectSingleByteXorCipher) {
   std::vector<std::string> ciphertexts;
   std::ifstream file("detect_single_byte_xor_cipher.txt");
@@ -31,5 +57,46 @@ TEST(SingleByteXorCipherTest, DetectSingleByteXorCipher) {
   EXPECT_EQ(170, result.pos);
 }
 
+TEST(SingleByteXorCipherTest, DetectTopK) {
+  std::string buffer;
+  std::vector<size_t> offsets = {0};
+  std::ifstream file("detect_single_byte_xor_cipher.txt");
+  ASSERT_TRUE(file.is_open());
+  std::string line;
+  while (std::getline(file, line)) {
+    buffer += absl::HexStringToBytes(line);
+    offsets.push_back(buffer.size());
+  }
+  file.close();
+
+  auto top = DetectSingleByteXorCipherTopK(buffer, offsets, 5, /*threads=*/4);
+  ASSERT_EQ(5, top.size());
+  EXPECT_EQ("Now that the party is jumping\n", top[0].plaintext);
+  EXPECT_EQ('5', top[0].key);
+  EXPECT_EQ(170, top[0].pos);
+  for (size_t i = 1; i < top.size(); i++) {
+    EXPECT_GE(top[i - 1].score, top[i].score);
+  }
+
+  // Same result single-threaded, and when streaming the file
+  auto single = DetectSingleByteXorCipherTopK(buffer, offsets, 5, 1);
+  auto streamed = DetectSingleByteXorCipherTopKInHexFile(
+      "detect_single_byte_xor_cipher.txt", 5);
+  for (const auto* other : {&single, &streamed}) {
+    ASSERT_EQ(top.size(), other->size());
+    for (size_t i = 0; i < top.size(); i++) {
+      EXPECT_EQ(top[i].pos, (*other)[i].pos);
+      EXPECT_EQ(top[i].key, (*other)[i].key);
+      EXPECT_EQ(top[i].plaintext, (*other)[i].plaintext);
+    }
+  }
+
+  EXPECT_EQ(offsets.size() - 1,
+            DetectSingleByteXorCipherTopK(buffer, offsets, 1000).size());
+  EXPECT_TRUE(DetectSingleByteXorCipherTopK(buffer, offsets, 0).empty());
+  EXPECT_THROW(DetectSingleByteXorCipherTopKInHexFile("no_such_file", 1),
+               std::runtime_error);
+}
+
 }  // namespace
 }  // namespace cryptopals
\ No newline at end of file
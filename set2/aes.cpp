@@ -71,13 +71,14 @@ std::string Aes::CbcEncrypt(std::string_view plaintext, std::string_view key,
   assert(iv.size() == kBlockSize);
   std::string ciphertext(plaintext.size(), 0);
   AES_KEY aes_key = GenerateAesEncryptKey(key);
-  std::string vector = std::string(iv);
+  const auto* vector = reinterpret_cast<const unsigned char*>(iv.data());
+  unsigned char input[kBlockSize];
   for (size_t i = 0; i < plaintext.size(); i += kBlockSize) {
-    std::string input = FixedXor(plaintext.substr(i, kBlockSize), vector);
-    const auto* in = reinterpret_cast<const unsigned char*>(input.data());
+    XorBytes(input, reinterpret_cast<const unsigned char*>(&plaintext[i]),
+             vector, kBlockSize);
     auto* out = reinterpret_cast<unsigned char*>(&ciphertext[i]);
-    AES_encrypt(in, out, &aes_key);
-    vector = ciphertext.substr(i, kBlockSize);
+    AES_encrypt(input, out, &aes_key);
+    vector = out;
   }
   return ciphertext;
 }
@@ -88,14 +89,13 @@ std::string Aes::CbcDecrypt(std::string_view ciphertext, std::string_view key,
   assert(iv.size() == kBlockSize);
   std::string plaintext(ciphertext.size(), 0);
   AES_KEY aes_key = GenerateAesDecryptKey(key);
-  std::string vector = std::string(iv);
-  std::string output = std::string(kBlockSize, 0);
+  const auto* vector = reinterpret_cast<const unsigned char*>(iv.data());
   for (size_t i = 0; i < ciphertext.size(); i += kBlockSize) {
     const auto* in = reinterpret_cast<const unsigned char*>(&ciphertext[i]);
-    auto* out = reinterpret_cast<unsigned char*>(output.data());
+    auto* out = reinterpret_cast<unsigned char*>(&plaintext[i]);
     AES_decrypt(in, out, &aes_key);
-    plaintext.replace(i, kBlockSize, FixedXor(output, vector));
-    vector = ciphertext.substr(i, kBlockSize);
+    XorBytes(out, out, vector, kBlockSize);
+    vector = in;
   }
   return plaintext;
 }
@@ -119,11 +119,10 @@ std::string Aes::CtrEncrypt(std::string_view plaintext, std::string_view key,
     auto* out = reinterpret_cast<unsigned char*>(key_stream.data());
     AES_encrypt(ctr_block, out, &aes_key);
 
-    // For the last block, string::replace and std::substr will copy len <
-    // kBlockSize when it meets std::npos, and FixedXor will return the XOR
-    // result with size == min(size(input1), size(input2)).
-    ciphertext.replace(i, kBlockSize,
-                       FixedXor(plaintext.substr(i, kBlockSize), key_stream));
+    // The last block may be partial.
+    size_t n = std::min<size_t>(kBlockSize, plaintext.size() - i);
+    XorBytes(reinterpret_cast<unsigned char*>(&ciphertext[i]),
+             reinterpret_cast<const unsigned char*>(&plaintext[i]), out, n);
     counter++;
   }
   return ciphertext;
@@ -149,14 +148,37 @@ std::string Aes::CtrDecrypt(std::string_view ciphertext, std::string_view key,
     auto* out = reinterpret_cast<unsigned char*>(key_stream.data());
     AES_encrypt(ctr_block, out, &aes_key);  // Note: CTR use AES *encryption*
 
-    // For the last block, string::replace and std::substr will copy len <
-    // kBlockSize when it meets std::npos, and FixedXor will return the XOR
-    // result with size == min(size(input1), size(input2)).
-    plaintext.replace(i, kBlockSize,
-                      FixedXor(ciphertext.substr(i, kBlockSize), key_stream));
+    // The last block may be partial.
+    size_t n = std::min<size_t>(kBlockSize, ciphertext.size() - i);
+    XorBytes(reinterpret_cast<unsigned char*>(&plaintext[i]),
+             reinterpret_cast<const unsigned char*>(&ciphertext[i]), out, n);
     counter++;
   }
   return plaintext;
 }
 
+std::string Aes::CtrKeyStream(std::string_view key, std::string_view nonce,
+                              std::string_view iv, uint32_t counter,
+                              size_t size) {
+  assert(nonce.size() == 4);
+  assert(iv.size() == 8);
+
+  std::string key_stream(size, 0);
+  AES_KEY aes_key = GenerateAesEncryptKey(key);
+  unsigned char block[kBlockSize];
+
+  unsigned char ctr_block[kBlockSize];
+  std::copy(nonce.begin(), nonce.end(), ctr_block);
+  std::copy(iv.begin(), iv.end(), ctr_block + 4);
+
+  for (size_t i = 0; i < size; i += kBlockSize) {
+    BigEndianSet(ctr_block + 12, counter);
+    AES_encrypt(ctr_block, block, &aes_key);
+    std::copy(block, block + std::min<size_t>(kBlockSize, size - i),
+              &key_stream[i]);
+    counter++;
+  }
+  return key_stream;
+}
+
 }  // namespace cryptopals
\ No newline at end of file
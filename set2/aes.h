@@ -30,6 +30,13 @@ class Aes {
   std::string static CtrDecrypt(std::string_view ciphertext,
                                 std::string_view key, std::string_view nonce,
                                 std::string_view iv);
+
+  // Produces `size` bytes of CTR key stream starting from block `counter`,
+  // i.e. CtrEncrypt(plaintext) == FixedXor(plaintext, CtrKeyStream(..., 1,
+  // plaintext.size())).
+  std::string static CtrKeyStream(std::string_view key, std::string_view nonce,
+                                  std::string_view iv, uint32_t counter,
+                                  size_t size);
 };
 
 }  // namespace cryptopals
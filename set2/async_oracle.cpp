@@ -0,0 +1,110 @@
+#include "async_oracle.h"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+namespace cryptopals {
+
+std::vector<std::string> AsyncEncryptionOracle::EncryptAll(
+    std::vector<std::string> inputs) {
+  std::vector<std::future<std::string>> futures;
+  futures.reserve(inputs.size());
+  for (auto& input : inputs) {
+    futures.push_back(EncryptAsync(std::move(input)));
+  }
+  std::vector<std::string> outputs;
+  outputs.reserve(futures.size());
+  for (auto& future : futures) {
+    outputs.push_back(future.get());
+  }
+  return outputs;
+}
+
+ConcurrentOracle::ConcurrentOracle(EncryptionOracle* oracle,
+                                   size_t max_in_flight)
+    : oracle_(oracle) {
+  if (max_in_flight == 0) {
+    throw std::invalid_argument("max_in_flight must be positive");
+  }
+  workers_.reserve(max_in_flight);
+  for (size_t i = 0; i < max_in_flight; i++) {
+    workers_.emplace_back(&ConcurrentOracle::WorkerLoop, this);
+  }
+}
+
+ConcurrentOracle::~ConcurrentOracle() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+std::future<std::string> ConcurrentOracle::EncryptAsync(std::string input) {
+  std::promise<std::string> promise;
+  std::future<std::string> future = promise.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    queue_.emplace_back(std::move(input), std::move(promise));
+  }
+  cv_.notify_one();
+  return future;
+}
+
+void ConcurrentOracle::WorkerLoop() {
+  for (;;) {
+    std::pair<std::string, std::promise<std::string>> query;
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      cv_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      query = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    try {
+      query.second.set_value(oracle_->Encrypt(query.first));
+    } catch (...) {
+      query.second.set_exception(std::current_exception());
+    }
+  }
+}
+
+std::string LatencyOracle::Encrypt(std::string_view input) {
+  {
+    std::unique_lock<std::mutex> lock(mu_);
+    cv_.wait(lock, [this]() { return in_flight_ < max_concurrency_; });
+    in_flight_++;
+    peak_ = std::max(peak_, in_flight_);
+  }
+  auto release = [this]() {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      in_flight_--;
+    }
+    cv_.notify_one();
+  };
+  const auto deadline = std::chrono::steady_clock::now() + latency_;
+  std::string output;
+  try {
+    output = oracle_->Encrypt(input);
+  } catch (...) {
+    release();
+    throw;
+  }
+  std::this_thread::sleep_until(deadline);
+  release();
+  return output;
+}
+
+size_t LatencyOracle::peak_concurrency() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return peak_;
+}
+
+}  // namespace cryptopals
@@ -0,0 +1,83 @@
+#ifndef CRYPTOPALS_SET2_ASYNC_ORACLE_H_
+#define CRYPTOPALS_SET2_ASYNC_ORACLE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "encryption_oracle.h"
+
+namespace cryptopals {
+
+// Asynchronous counterpart of EncryptionOracle. EncryptAsync returns at
+// once and the ciphertext (or the exception of the query) arrives through
+// the future, so an attack can keep independent queries in flight instead
+// of paying one round trip per query.
+class AsyncEncryptionOracle {
+ public:
+  virtual ~AsyncEncryptionOracle() = default;
+  virtual std::future<std::string> EncryptAsync(std::string input) = 0;
+
+  // Issues all inputs before waiting for any; outputs are in input order.
+  std::vector<std::string> EncryptAll(std::vector<std::string> inputs);
+};
+
+// Adapts a thread-safe synchronous oracle: queries run on `max_in_flight`
+// worker threads, further ones wait in a queue. The destructor finishes the
+// queued queries and joins the workers. `oracle` must outlive the adapter.
+class ConcurrentOracle : public AsyncEncryptionOracle {
+ public:
+  ConcurrentOracle(EncryptionOracle* oracle, size_t max_in_flight);
+  ~ConcurrentOracle() override;
+  ConcurrentOracle(const ConcurrentOracle&) = delete;
+  ConcurrentOracle& operator=(const ConcurrentOracle&) = delete;
+
+  std::future<std::string> EncryptAsync(std::string input) override;
+
+ private:
+  void WorkerLoop();
+
+  EncryptionOracle* const oracle_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<std::pair<std::string, std::promise<std::string>>> queue_;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
+};
+
+// Local stand-in for a remote oracle: every query takes at least `latency`,
+// and at most `max_concurrency` queries are served at once (like a server
+// with a fixed number of workers); callers beyond that block until a slot
+// frees up. Thread-safe as long as `oracle` is.
+class LatencyOracle : public EncryptionOracle {
+ public:
+  LatencyOracle(EncryptionOracle* oracle, std::chrono::microseconds latency,
+                size_t max_concurrency)
+      : oracle_(oracle), latency_(latency), max_concurrency_(max_concurrency) {}
+
+  std::string Encrypt(std::string_view input) override;
+
+  // Highest number of queries that were served at the same time.
+  size_t peak_concurrency() const;
+
+ private:
+  EncryptionOracle* const oracle_;
+  const std::chrono::microseconds latency_;
+  const size_t max_concurrency_;
+  mutable std::mutex mu_;
+  std::condition_variable cv_;
+  size_t in_flight_ = 0;
+  size_t peak_ = 0;
+};
+
+}  // namespace cryptopals
+
+#endif  // CRYPTOPALS_SET2_ASYNC_ORACLE_H_
@@ -0,0 +1,76 @@
+#include "async_oracle.h"
+
+#include <cctype>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+#include "gtest/gtest.h"
+
+namespace cryptopals {
+namespace {
+
+class UpperOracle : public EncryptionOracle {
+ public:
+  std::string Encrypt(std::string_view input) override {
+    if (input.empty()) throw std::invalid_argument("empty input");
+    std::string output(input);
+    for (char& c : output) c = static_cast<char>(std::toupper(c));
+    return output;
+  }
+};
+
+TEST(ConcurrentOracleTest, ResultsInOrder) {
+  UpperOracle upper;
+  ConcurrentOracle oracle(&upper, 8);
+  std::vector<std::string> inputs;
+  for (int i = 0; i < 1000; i++) {
+    inputs.push_back("query" + std::to_string(i));
+  }
+  auto outputs = oracle.EncryptAll(inputs);
+  ASSERT_EQ(inputs.size(), outputs.size());
+  for (size_t i = 0; i < inputs.size(); i++) {
+    EXPECT_EQ("QUERY" + std::to_string(i), outputs[i]);
+  }
+}
+
+TEST(ConcurrentOracleTest, ExceptionsReachTheFuture) {
+  UpperOracle upper;
+  ConcurrentOracle oracle(&upper, 2);
+  auto failing = oracle.EncryptAsync("");
+  auto ok = oracle.EncryptAsync("ok");
+  EXPECT_THROW(failing.get(), std::invalid_argument);
+  EXPECT_EQ("OK", ok.get());
+  EXPECT_THROW(ConcurrentOracle(&upper, 0), std::invalid_argument);
+}
+
+TEST(LatencyOracleTest, LimitsConcurrency) {
+  UpperOracle upper;
+  LatencyOracle remote(&upper, std::chrono::milliseconds(5), 4);
+  ConcurrentOracle oracle(&remote, 16);
+  const auto start = std::chrono::steady_clock::now();
+  auto outputs = oracle.EncryptAll(std::vector<std::string>(16, "x"));
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(std::vector<std::string>(16, "X"), outputs);
+  EXPECT_EQ(4, remote.peak_concurrency());
+  // 16 queries, 4 at a time, 5 ms each
+  EXPECT_GE(elapsed, std::chrono::milliseconds(20));
+}
+
+TEST(LatencyOracleTest, ConcurrencyHidesLatency) {
+  UpperOracle upper;
+  LatencyOracle remote(&upper, std::chrono::milliseconds(10), 32);
+  ConcurrentOracle oracle(&remote, 32);
+  const auto start = std::chrono::steady_clock::now();
+  oracle.EncryptAll(std::vector<std::string>(32, "x"));
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  // Timing depends on the machine, so it is only printed; one at a time
+  // would take 320 ms.
+  std::cout << "32 queries of 10 ms in " << elapsed.count() << " ms"
+            << std::endl;
+  EXPECT_GE(remote.peak_concurrency(), 16);
+}
+
+}  // namespace
+}  // namespace cryptopals
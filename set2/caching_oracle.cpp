@@ -0,0 +1,62 @@
+#include "caching_oracle.h"
+
+#include <cstdio>
+
+namespace cryptopals {
+
+std::string CacheStats::Report() const {
+  char buffer[160];
+  std::snprintf(buffer, sizeof(buffer),
+                "%llu/%llu queries answered from cache (%.1f%%), "
+                "%llu evictions, %zu entries in %zu bytes",
+                static_cast<unsigned long long>(hits),
+                static_cast<unsigned long long>(hits + misses),
+                HitRate() * 100, static_cast<unsigned long long>(evictions),
+                entries, bytes);
+  return buffer;
+}
+
+std::string CachingOracle::Encrypt(std::string_view input) {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = index_.find(input);
+    if (it != index_.end()) {
+      stats_.hits++;
+      lru_.splice(lru_.begin(), lru_, it->second);
+      return it->second->output;
+    }
+    stats_.misses++;
+  }
+
+  std::string output = oracle_->Encrypt(input);
+  Entry entry{std::string(input), output};
+  const size_t bytes = entry.Bytes();
+  if (bytes > max_bytes_) {
+    return output;
+  }
+  std::lock_guard<std::mutex> lock(mu_);
+  if (index_.contains(input)) {
+    // Another thread missed on the same input and got here first.
+    return output;
+  }
+  while (stats_.bytes + bytes > max_bytes_) {
+    const Entry& victim = lru_.back();
+    stats_.bytes -= victim.Bytes();
+    index_.erase(std::string_view(victim.input));
+    lru_.pop_back();
+    stats_.evictions++;
+  }
+  lru_.push_front(std::move(entry));
+  index_.emplace(std::string_view(lru_.front().input), lru_.begin());
+  stats_.bytes += bytes;
+  return output;
+}
+
+CacheStats CachingOracle::Stats() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  CacheStats stats = stats_;
+  stats.entries = lru_.size();
+  return stats;
+}
+
+}  // namespace cryptopals
@@ -0,0 +1,74 @@
+#ifndef CRYPTOPALS_SET2_CACHING_ORACLE_H_
+#define CRYPTOPALS_SET2_CACHING_ORACLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "absl/container/flat_hash_map.h"
+#include "encryption_oracle.h"
+
+namespace cryptopals {
+
+struct CacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+  size_t entries = 0;
+  size_t bytes = 0;  // accounted size of the cached entries
+
+  double HitRate() const {
+    return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0;
+  }
+  // e.g. "42/120 queries answered from cache (35.0%), 3 evictions,
+  // 75 entries in 9216 bytes"
+  std::string Report() const;
+};
+
+// Memoises a deterministic oracle: a repeated input is answered from memory
+// instead of querying `oracle` again. Entries are looked up by a hash of the
+// input and compared in full, so there are no false hits. The cache holds at
+// most `max_bytes` (inputs, outputs and a fixed per-entry overhead) and
+// evicts the least recently used entries beyond that; responses bigger than
+// the whole budget are passed through uncached.
+//
+// Thread-safe if `oracle` is. The lock is not held while `oracle` runs, so
+// two threads missing on the same input both query it.
+class CachingOracle : public EncryptionOracle {
+ public:
+  static constexpr size_t kEntryOverhead = 64;
+
+  CachingOracle(EncryptionOracle* oracle, size_t max_bytes)
+      : oracle_(oracle), max_bytes_(max_bytes) {}
+  CachingOracle(const CachingOracle&) = delete;
+  CachingOracle& operator=(const CachingOracle&) = delete;
+
+  std::string Encrypt(std::string_view input) override;
+
+  CacheStats Stats() const;
+
+ private:
+  struct Entry {
+    std::string input;
+    std::string output;
+    size_t Bytes() const {
+      return input.size() + output.size() + kEntryOverhead;
+    }
+  };
+  using Lru = std::list<Entry>;  // most recently used first
+
+  EncryptionOracle* const oracle_;
+  const size_t max_bytes_;
+  mutable std::mutex mu_;
+  Lru lru_;
+  // Keys point into the inputs of `lru_`, which list nodes keep in place.
+  absl::flat_hash_map<std::string_view, Lru::iterator> index_;
+  CacheStats stats_;
+};
+
+}  // namespace cryptopals
+
+#endif  // CRYPTOPALS_SET2_CACHING_ORACLE_H_
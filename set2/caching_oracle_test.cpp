@@ -0,0 +1,95 @@
+#include "caching_oracle.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace cryptopals {
+namespace {
+
+// Deterministic, counts the queries that reach it.
+class ReverseOracle : public EncryptionOracle {
+ public:
+  std::string Encrypt(std::string_view input) override {
+    calls++;
+    return std::string(input.rbegin(), input.rend());
+  }
+  std::atomic<int> calls{0};
+};
+
+TEST(CachingOracleTest, AnswersRepeatsFromCache) {
+  ReverseOracle reverse;
+  CachingOracle oracle(&reverse, 1 << 20);
+  EXPECT_EQ("cba", oracle.Encrypt("abc"));
+  EXPECT_EQ("cba", oracle.Encrypt("abc"));
+  EXPECT_EQ("fed", oracle.Encrypt("def"));
+  EXPECT_EQ("cba", oracle.Encrypt("abc"));
+  EXPECT_EQ(2, reverse.calls);
+
+  CacheStats stats = oracle.Stats();
+  EXPECT_EQ(2, stats.hits);
+  EXPECT_EQ(2, stats.misses);
+  EXPECT_EQ(0.5, stats.HitRate());
+  EXPECT_EQ(2, stats.entries);
+  EXPECT_EQ(2 * (6 + CachingOracle::kEntryOverhead), stats.bytes);
+  EXPECT_EQ("2/4 queries answered from cache (50.0%), 0 evictions, "
+            "2 entries in 140 bytes",
+            stats.Report());
+}
+
+TEST(CachingOracleTest, EvictsLeastRecentlyUsed) {
+  ReverseOracle reverse;
+  constexpr size_t kEntry = 2 + CachingOracle::kEntryOverhead;
+  CachingOracle oracle(&reverse, 3 * kEntry);
+  oracle.Encrypt("a");
+  oracle.Encrypt("b");
+  oracle.Encrypt("c");
+  oracle.Encrypt("a");  // "b" is now the oldest
+  oracle.Encrypt("d");  // evicts "b"
+  EXPECT_EQ(1, oracle.Stats().evictions);
+  EXPECT_EQ(3, oracle.Stats().entries);
+  EXPECT_LE(oracle.Stats().bytes, 3 * kEntry);
+
+  reverse.calls = 0;
+  oracle.Encrypt("a");
+  oracle.Encrypt("c");
+  oracle.Encrypt("d");
+  EXPECT_EQ(0, reverse.calls);
+  oracle.Encrypt("b");
+  EXPECT_EQ(1, reverse.calls);
+}
+
+TEST(CachingOracleTest, OversizedResponsesPassThrough) {
+  ReverseOracle reverse;
+  CachingOracle oracle(&reverse, 100);
+  std::string big(100, 'x');
+  oracle.Encrypt(big);
+  oracle.Encrypt(big);
+  EXPECT_EQ(2, reverse.calls);
+  EXPECT_EQ(0, oracle.Stats().entries);
+}
+
+TEST(CachingOracleTest, ConcurrentQueries) {
+  ReverseOracle reverse;
+  CachingOracle oracle(&reverse, 1 << 20);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&oracle]() {
+      for (int i = 0; i < 1000; i++) {
+        std::string input = std::to_string(i % 50);
+        EXPECT_EQ(std::string(input.rbegin(), input.rend()),
+                  oracle.Encrypt(input));
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  CacheStats stats = oracle.Stats();
+  EXPECT_EQ(4000, stats.hits + stats.misses);
+  EXPECT_EQ(50, stats.entries);
+  EXPECT_EQ(stats.misses, reverse.calls);
+}
+
+}  // namespace
+}  // namespace cryptopals
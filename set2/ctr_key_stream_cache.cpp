@@ -0,0 +1,144 @@
+#include "ctr_key_stream_cache.h"
+
+#include <cassert>
+
+#include "../set1/fixed_xor.h"
+#include "aes.h"
+
+namespace cryptopals {
+
+namespace {
+
+constexpr size_t kBlockSize = 16;  // 128-bit block
+
+size_t RoundUpToBlock(size_t size) {
+  return (size + kBlockSize - 1) / kBlockSize * kBlockSize;
+}
+
+}  // namespace
+
+double CtrKeyStreamCache::Stats::HitRate() const {
+  uint64_t lookups = hits + extensions + misses + bypasses;
+  return lookups == 0 ? 0 : static_cast<double>(hits) / lookups;
+}
+
+double CtrKeyStreamCache::Stats::ByteHitRate() const {
+  uint64_t total = cached_bytes + generated_bytes;
+  return total == 0 ? 0 : static_cast<double>(cached_bytes) / total;
+}
+
+std::string CtrKeyStreamCache::Encrypt(std::string_view plaintext,
+                                       std::string_view key,
+                                       std::string_view nonce,
+                                       std::string_view iv) {
+  assert(nonce.size() == 4);
+  assert(iv.size() == 8);
+  size_t stream_size = RoundUpToBlock(plaintext.size());
+  if (stream_size > budget_bytes_) {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      stats_.bypasses++;
+      stats_.generated_bytes += stream_size;
+    }
+    return Aes::CtrEncrypt(plaintext, key, nonce, iv);
+  }
+
+  std::string id;
+  id.reserve(key.size() + nonce.size() + iv.size());
+  id.append(key).append(nonce).append(iv);
+
+  // Only the lookup and the bookkeeping happen under the lock; key stream
+  // generation and the XOR work on an immutable snapshot, so callers of
+  // different (or the same) keys run in parallel.
+  std::shared_ptr<const std::string> key_stream;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto [it, inserted] = entries_.try_emplace(id);
+    Entry& entry = it->second;
+    key_stream = entry.key_stream;
+    size_t cached_size = key_stream ? key_stream->size() : 0;
+    if (inserted) {
+      lru_.push_front(id);
+      stats_.misses++;
+    } else {
+      lru_.splice(lru_.begin(), lru_, entry.lru_pos);
+      if (cached_size >= stream_size) {
+        stats_.hits++;
+      } else {
+        stats_.extensions++;
+      }
+    }
+    entry.lru_pos = lru_.begin();
+    if (cached_size >= stream_size) {
+      stats_.cached_bytes += stream_size;
+    } else {
+      stats_.cached_bytes += cached_size;
+      stats_.generated_bytes += stream_size - cached_size;
+    }
+  }
+
+  size_t cached_size = key_stream ? key_stream->size() : 0;
+  if (cached_size < stream_size) {
+    // Counter starts from 1, so the next block to generate is
+    // `cached_size / kBlockSize + 1`.
+    auto extended = std::make_shared<std::string>();
+    extended->reserve(stream_size);
+    if (key_stream) {
+      extended->append(*key_stream);
+    }
+    extended->append(Aes::CtrKeyStream(
+        key, nonce, iv, static_cast<uint32_t>(cached_size / kBlockSize + 1),
+        stream_size - cached_size));
+    key_stream = std::move(extended);
+    Install(std::move(id), key_stream);
+  }
+
+  return FixedXor(plaintext, *key_stream);
+}
+
+std::string CtrKeyStreamCache::Decrypt(std::string_view ciphertext,
+                                       std::string_view key,
+                                       std::string_view nonce,
+                                       std::string_view iv) {
+  return Encrypt(ciphertext, key, nonce, iv);
+}
+
+CtrKeyStreamCache::Stats CtrKeyStreamCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return stats_;
+}
+
+void CtrKeyStreamCache::Install(
+    std::string id, std::shared_ptr<const std::string> key_stream) {
+  std::lock_guard<std::mutex> lock(mu_);
+  // The entry may have been evicted meanwhile, or extended further by another
+  // caller; only a longer key stream replaces the cached one.
+  auto [it, inserted] = entries_.try_emplace(id);
+  Entry& entry = it->second;
+  if (inserted) {
+    lru_.push_front(std::move(id));
+  } else {
+    lru_.splice(lru_.begin(), lru_, entry.lru_pos);
+  }
+  entry.lru_pos = lru_.begin();
+  size_t cached_size = entry.key_stream ? entry.key_stream->size() : 0;
+  if (key_stream->size() > cached_size) {
+    stats_.resident_bytes += key_stream->size() - cached_size;
+    entry.key_stream = std::move(key_stream);
+  }
+  EvictLocked();
+}
+
+void CtrKeyStreamCache::EvictLocked() {
+  while (stats_.resident_bytes > budget_bytes_ && lru_.size() > 1) {
+    auto it = entries_.find(lru_.back());
+    if (it->second.key_stream) {
+      stats_.resident_bytes -= it->second.key_stream->size();
+    }
+    stats_.evictions++;
+    entries_.erase(it);
+    lru_.pop_back();
+  }
+}
+
+}  // namespace cryptopals
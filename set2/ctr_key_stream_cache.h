@@ -0,0 +1,81 @@
+#ifndef CRYPTOPALS_SET2_CTR_KEY_STREAM_CACHE_H_
+#define CRYPTOPALS_SET2_CTR_KEY_STREAM_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "absl/container/flat_hash_map.h"
+
+namespace cryptopals {
+
+// Opt-in cache for CTR traffic that reuses the same (key, nonce, iv).
+//
+// Key streams are generated in whole blocks from counter 1, kept per
+// (key, nonce, iv) and extended lazily when a longer message shows up. Once
+// the cached key streams exceed `budget_bytes`, the least recently used ones
+// are evicted. A message whose key stream alone exceeds the budget bypasses
+// the cache.
+//
+// Encrypt/Decrypt produce exactly the same output as Aes::CtrEncrypt/
+// Aes::CtrDecrypt. The cache is thread-safe; the lock only covers lookups and
+// bookkeeping, key stream generation and the XOR run outside of it.
+class CtrKeyStreamCache {
+ public:
+  struct Stats {
+    uint64_t hits;        // key stream fully served from cache
+    uint64_t extensions;  // cached key stream was too short and got extended
+    uint64_t misses;      // no cached key stream for (key, nonce, iv)
+    uint64_t bypasses;    // key stream larger than the whole budget
+    uint64_t evictions;
+    uint64_t cached_bytes;     // key stream bytes served from cache
+    uint64_t generated_bytes;  // key stream bytes produced by AES
+    size_t resident_bytes;     // current key stream bytes held in cache
+
+    // Fraction of lookups that did not generate any key stream.
+    double HitRate() const;
+    // Fraction of key stream bytes that did not need to be generated.
+    double ByteHitRate() const;
+  };
+
+  explicit CtrKeyStreamCache(size_t budget_bytes)
+      : budget_bytes_(budget_bytes) {}
+
+  // `nonce` is 32-bit, `iv` is 64-bit, see Aes::CtrEncrypt.
+  std::string Encrypt(std::string_view plaintext, std::string_view key,
+                      std::string_view nonce, std::string_view iv);
+  std::string Decrypt(std::string_view ciphertext, std::string_view key,
+                      std::string_view nonce, std::string_view iv);
+
+  Stats GetStats() const;
+
+ private:
+  struct Entry {
+    // Always a multiple of the block size; null until first generated. Never
+    // modified once cached, extending replaces it with a longer copy.
+    std::shared_ptr<const std::string> key_stream;
+    std::list<std::string>::iterator lru_pos;
+  };
+
+  // Caches `key_stream` for `id` unless a longer one is cached already, then
+  // evicts down to the budget.
+  void Install(std::string id, std::shared_ptr<const std::string> key_stream);
+  // Evicts least recently used entries other than the most recent one until
+  // resident bytes fit in the budget.
+  void EvictLocked();
+
+  const size_t budget_bytes_;
+  mutable std::mutex mu_;
+  // Key is key | nonce | iv, where the size of `key` is implied by the total
+  // length since nonce and iv are fixed-size.
+  absl::flat_hash_map<std::string, Entry> entries_;
+  std::list<std::string> lru_;  // front is the most recently used
+  Stats stats_ = {};
+};
+
+}  // namespace cryptopals
+
+#endif  // CRYPTOPALS_SET2_CTR_KEY_STREAM_CACHE_H_
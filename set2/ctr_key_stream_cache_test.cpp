@@ -0,0 +1,113 @@
+#include "ctr_key_stream_cache.h"
+
+#include <thread>
+#include <vector>
+
+#include "aes.h"
+#include "gtest/gtest.h"
+#include "rand_util.h"
+
+namespace cryptopals {
+namespace {
+
+TEST(AesCtrKeyStreamTest, MatchesCtrEncrypt) {
+  std::string key = "YELLOW SUBMARINE";
+  std::string nonce = util::RandStr(4);
+  std::string iv = util::RandStr(8);
+  std::string zeros(37, 0);
+  EXPECT_EQ(Aes::CtrEncrypt(zeros, key, nonce, iv),
+            Aes::CtrKeyStream(key, nonce, iv, 1, zeros.size()));
+  // Starting from the 3rd block
+  EXPECT_EQ(Aes::CtrEncrypt(zeros, key, nonce, iv).substr(32),
+            Aes::CtrKeyStream(key, nonce, iv, 3, 5));
+}
+
+TEST(CtrKeyStreamCacheTest, SameAsUncached) {
+  CtrKeyStreamCache cache(1024);
+  std::string key = "YELLOW SUBMARINE";
+  std::string nonce = util::RandStr(4);
+  std::string iv = util::RandStr(8);
+  for (uint8_t size : {20, 5, 64, 200, 3}) {
+    std::string plaintext = util::RandStr(size);
+    std::string ciphertext = cache.Encrypt(plaintext, key, nonce, iv);
+    EXPECT_EQ(Aes::CtrEncrypt(plaintext, key, nonce, iv), ciphertext);
+    EXPECT_EQ(plaintext, cache.Decrypt(ciphertext, key, nonce, iv));
+  }
+  // 20 -> miss, 5 -> hit, 64 -> extension, 200 -> extension, the rest are all
+  // hits.
+  auto stats = cache.GetStats();
+  EXPECT_EQ(1, stats.misses);
+  EXPECT_EQ(2, stats.extensions);
+  EXPECT_EQ(7, stats.hits);
+  EXPECT_EQ(208, stats.resident_bytes);
+  EXPECT_EQ(208, stats.generated_bytes);
+  EXPECT_DOUBLE_EQ(0.7, stats.HitRate());
+}
+
+TEST(CtrKeyStreamCacheTest, EvictLeastRecentlyUsed) {
+  CtrKeyStreamCache cache(64);
+  std::string nonce(4, 0);
+  std::string iv(8, 0);
+  std::string plaintext(32, 'x');
+  std::string key_a(16, 'a'), key_b(16, 'b'), key_c(16, 'c');
+  cache.Encrypt(plaintext, key_a, nonce, iv);
+  cache.Encrypt(plaintext, key_b, nonce, iv);
+  cache.Encrypt(plaintext, key_a, nonce, iv);  // hit, b is now the oldest
+  cache.Encrypt(plaintext, key_c, nonce, iv);  // evicts b
+  cache.Encrypt(plaintext, key_a, nonce, iv);  // hit
+  EXPECT_EQ(Aes::CtrEncrypt(plaintext, key_b, nonce, iv),
+            cache.Encrypt(plaintext, key_b, nonce, iv));  // miss, evicts c
+
+  auto stats = cache.GetStats();
+  EXPECT_EQ(2, stats.hits);
+  EXPECT_EQ(4, stats.misses);
+  EXPECT_EQ(2, stats.evictions);
+  EXPECT_EQ(64, stats.resident_bytes);
+}
+
+TEST(CtrKeyStreamCacheTest, BypassOverBudget) {
+  CtrKeyStreamCache cache(16);
+  std::string key = "YELLOW SUBMARINE";
+  std::string nonce(4, 0);
+  std::string iv(8, 0);
+  std::string plaintext(17, 'x');
+  EXPECT_EQ(Aes::CtrEncrypt(plaintext, key, nonce, iv),
+            cache.Encrypt(plaintext, key, nonce, iv));
+  auto stats = cache.GetStats();
+  EXPECT_EQ(1, stats.bypasses);
+  EXPECT_EQ(0, stats.resident_bytes);
+}
+
+// Callers extend and evict each other's entries while generating outside the
+// lock; every result must still match the uncached cipher.
+TEST(CtrKeyStreamCacheTest, ConcurrentCallers) {
+  CtrKeyStreamCache cache(1024);
+  std::string nonce(4, 0);
+  std::string iv(8, 0);
+  std::vector<std::thread> threads;
+  std::vector<int> mismatches(8, 0);
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < 200; i++) {
+        std::string key(16, static_cast<char>('a' + (t + i) % 4));
+        std::string plaintext(1 + (i * 37 + t) % 400, 'x');
+        if (cache.Encrypt(plaintext, key, nonce, iv) !=
+            Aes::CtrEncrypt(plaintext, key, nonce, iv)) {
+          mismatches[t]++;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int count : mismatches) {
+    EXPECT_EQ(0, count);
+  }
+  auto stats = cache.GetStats();
+  EXPECT_EQ(8 * 200, stats.hits + stats.extensions + stats.misses);
+  EXPECT_LE(stats.resident_bytes, 1024);
+}
+
+}  // namespace
+}  // namespace cryptopals
@@ -0,0 +1,144 @@
+// Load generator for ctr_server, reports p50/p99 latency and requests/s.
+//
+// Usage:
+//   ctr_load --socket=PATH [--connections=N] [--depth=N] [--requests=N]
+//       [--size=BYTES]
+//
+// Each connection keeps `depth` requests in flight and sends `requests`
+// requests of `size` bytes in total.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "aes.h"
+#include "ctr_service.h"
+
+namespace cryptopals {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct LoadOptions {
+  std::string socket_path;
+  int connections = 8;
+  int depth = 16;
+  int requests = 10000;
+  size_t size = 64;
+};
+
+// Runs one connection, returns the latency of every request in microseconds.
+std::vector<double> RunConnection(const LoadOptions& options, int index) {
+  auto client = CtrClient::Connect(options.socket_path);
+  CtrRequest request;
+  request.op = CtrOp::ENCRYPT;
+  request.key = std::string(16, static_cast<char>('a' + index % 4));
+  request.nonce = std::string(4, 0);
+  request.iv = std::string(8, static_cast<char>(index));
+  request.payload = std::string(options.size, 'x');
+  std::string expected =
+      Aes::CtrEncrypt(request.payload, request.key, request.nonce, request.iv);
+
+  std::vector<Clock::time_point> sent(options.requests);
+  std::vector<double> latencies;
+  latencies.reserve(options.requests);
+  int next = 0;
+  auto send_next = [&]() {
+    request.id = next;
+    sent[next] = Clock::now();
+    client->Send(request);
+    next++;
+  };
+  while (next < std::min(options.depth, options.requests)) send_next();
+  for (int received = 0; received < options.requests; received++) {
+    CtrResponse response = client->Receive();
+    latencies.push_back(std::chrono::duration<double, std::micro>(
+                            Clock::now() - sent[response.id])
+                            .count());
+    if (!response.ok || response.payload != expected) {
+      throw std::runtime_error("unexpected response for request " +
+                               std::to_string(response.id));
+    }
+    if (next < options.requests) send_next();
+  }
+  return latencies;
+}
+
+int Main(int argc, char** argv) {
+  LoadOptions options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto value = [&arg](const std::string& flag) -> const char* {
+      return arg.rfind(flag + "=", 0) == 0 ? arg.c_str() + flag.size() + 1
+                                           : nullptr;
+    };
+    if (const char* v = value("--socket")) {
+      options.socket_path = v;
+    } else if (const char* v = value("--connections")) {
+      options.connections = std::max(1, std::atoi(v));
+    } else if (const char* v = value("--depth")) {
+      options.depth = std::max(1, std::atoi(v));
+    } else if (const char* v = value("--requests")) {
+      options.requests = std::max(1, std::atoi(v));
+    } else if (const char* v = value("--size")) {
+      options.size = std::atoll(v);
+    } else {
+      options.socket_path.clear();
+      break;
+    }
+  }
+  if (options.socket_path.empty()) {
+    std::cerr << "Usage: ctr_load --socket=PATH [--connections=N] [--depth=N] "
+                 "[--requests=N] [--size=BYTES]\n";
+    return 2;
+  }
+
+  std::vector<double> latencies;
+  std::mutex mu;
+  std::exception_ptr error;
+  std::vector<std::thread> threads;
+  auto start = Clock::now();
+  for (int i = 0; i < options.connections; i++) {
+    threads.emplace_back([&, i]() {
+      try {
+        auto result = RunConnection(options, i);
+        std::lock_guard<std::mutex> lock(mu);
+        latencies.insert(latencies.end(), result.begin(), result.end());
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mu);
+        error = std::current_exception();
+      }
+    });
+  }
+  for (auto& t : threads) t.join();
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  if (error) std::rethrow_exception(error);
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double p) {
+    return latencies[std::min(latencies.size() - 1,
+                              static_cast<size_t>(p * latencies.size()))];
+  };
+  std::cout << latencies.size() << " requests in " << seconds << " s: "
+            << latencies.size() / seconds << " req/s, p50 " << percentile(0.5)
+            << " us, p99 " << percentile(0.99) << " us" << std::endl;
+  return 0;
+}
+
+}  // namespace
+}  // namespace cryptopals
+
+int main(int argc, char** argv) {
+  try {
+    return cryptopals::Main(argc, argv);
+  } catch (const std::exception& e) {
+    std::cerr << "ctr_load: " << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,66 @@
+// Runs CtrServer until SIGINT/SIGTERM.
+//
+// Usage:
+//   ctr_server --socket=PATH [--max_batch_kib=N] [--batch_delay_us=N]
+
+#include <csignal>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "ctr_service.h"
+
+int main(int argc, char** argv) {
+  cryptopals::CtrServerOptions options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto value = [&arg](const std::string& flag) -> const char* {
+      return arg.rfind(flag + "=", 0) == 0 ? arg.c_str() + flag.size() + 1
+                                           : nullptr;
+    };
+    if (const char* v = value("--socket")) {
+      options.socket_path = v;
+    } else if (const char* v = value("--max_batch_kib")) {
+      options.max_batch_bytes = std::atoll(v) * 1024;
+    } else if (const char* v = value("--batch_delay_us")) {
+      options.max_batch_delay = std::chrono::microseconds(std::atoll(v));
+    } else {
+      options.socket_path.clear();
+      break;
+    }
+  }
+  if (options.socket_path.empty()) {
+    std::cerr << "Usage: ctr_server --socket=PATH [--max_batch_kib=N] "
+                 "[--batch_delay_us=N]\n";
+    return 2;
+  }
+
+  // Block the signals before any thread is spawned so that only sigwait
+  // below sees them.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  cryptopals::CtrServer server(options);
+  try {
+    server.Start();
+  } catch (const std::exception& e) {
+    std::cerr << "ctr_server: " << e.what() << std::endl;
+    return 1;
+  }
+  std::cerr << "ctr_server: listening on " << options.socket_path << std::endl;
+  int signal;
+  sigwait(&signals, &signal);
+  server.Stop();
+
+  auto stats = server.GetStats();
+  std::cerr << "ctr_server: " << stats.connections << " connections ("
+            << stats.dropped_connections << " dropped), " << stats.requests
+            << " requests in " << stats.batches
+            << " batches (" << stats.payload_bytes << " payload bytes)"
+            << std::endl;
+  return 0;
+}
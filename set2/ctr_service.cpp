@@ -0,0 +1,532 @@
+#include "ctr_service.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "../set1/fixed_xor.h"
+
+namespace cryptopals {
+
+namespace {
+
+constexpr size_t kBlockSize = 16;  // 128-bit block
+constexpr size_t kNonceSize = 4;
+constexpr size_t kIvSize = 8;
+constexpr size_t kRequestHeaderSize = 4 + 1 + 1 + 4;
+constexpr size_t kResponseHeaderSize = 4 + 1 + 4;
+// Refuse frames that are obviously not meant for us instead of buffering
+// them forever.
+constexpr uint32_t kMaxPayloadSize = 64 * 1024 * 1024;
+
+void AppendU32(std::string* out, uint32_t val) {
+  out->push_back(static_cast<char>(val >> 24u));
+  out->push_back(static_cast<char>(val >> 16u));
+  out->push_back(static_cast<char>(val >> 8u));
+  out->push_back(static_cast<char>(val));
+}
+
+uint32_t ReadU32(std::string_view in) {
+  const auto* p = reinterpret_cast<const uint8_t*>(in.data());
+  return (uint32_t)p[0] << 24u | (uint32_t)p[1] << 16u | (uint32_t)p[2] << 8u |
+         (uint32_t)p[3];
+}
+
+// `dest` needs to have 32 bits reserved
+void BigEndianSet(char* dest, uint32_t counter) {
+  dest[3] = static_cast<char>(counter & 0xffu);
+  dest[2] = static_cast<char>((counter >> 8u) & 0xffu);
+  dest[1] = static_cast<char>((counter >> 16u) & 0xffu);
+  dest[0] = static_cast<char>((counter >> 24u) & 0xffu);
+}
+
+const EVP_CIPHER* EcbCipherFor(size_t key_size) {
+  switch (key_size) {
+    case 16:
+      return EVP_aes_128_ecb();
+    case 24:
+      return EVP_aes_192_ecb();
+    case 32:
+      return EVP_aes_256_ecb();
+    default:
+      return nullptr;
+  }
+}
+
+void WriteAll(int fd, std::string_view data) {
+  while (!data.empty()) {
+    ssize_t n = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      throw std::runtime_error(std::string("send: ") + std::strerror(errno));
+    }
+    data.remove_prefix(n);
+  }
+}
+
+// Appends whatever is readable to `buffer`. Returns false on EOF or error.
+bool ReadSome(int fd, std::string* buffer) {
+  char chunk[64 * 1024];
+  ssize_t n;
+  do {
+    n = recv(fd, chunk, sizeof(chunk), 0);
+  } while (n < 0 && errno == EINTR);
+  if (n <= 0) {
+    return false;
+  }
+  buffer->append(chunk, n);
+  return true;
+}
+
+sockaddr_un SocketAddress(const std::string& path) {
+  sockaddr_un addr = {};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    throw std::runtime_error("socket path too long: " + path);
+  }
+  std::copy(path.begin(), path.end(), addr.sun_path);
+  return addr;
+}
+
+}  // namespace
+
+std::string EncodeRequest(const CtrRequest& request) {
+  std::string frame;
+  frame.reserve(kRequestHeaderSize + request.key.size() + kNonceSize +
+                kIvSize + request.payload.size());
+  AppendU32(&frame, request.id);
+  frame.push_back(static_cast<char>(request.op));
+  frame.push_back(static_cast<char>(request.key.size()));
+  AppendU32(&frame, request.payload.size());
+  frame += request.key;
+  frame += request.nonce;
+  frame += request.iv;
+  frame += request.payload;
+  return frame;
+}
+
+std::string EncodeResponse(const CtrResponse& response) {
+  std::string frame;
+  frame.reserve(kResponseHeaderSize + response.payload.size());
+  AppendU32(&frame, response.id);
+  frame.push_back(response.ok ? 1 : 0);
+  AppendU32(&frame, response.payload.size());
+  frame += response.payload;
+  return frame;
+}
+
+size_t DecodeRequest(std::string_view buffer, CtrRequest* request) {
+  if (buffer.size() < kRequestHeaderSize) {
+    return 0;
+  }
+  auto op = static_cast<uint8_t>(buffer[4]);
+  auto key_size = static_cast<uint8_t>(buffer[5]);
+  uint32_t payload_size = ReadU32(buffer.substr(6));
+  if (op > static_cast<uint8_t>(CtrOp::DECRYPT) ||
+      payload_size > kMaxPayloadSize) {
+    throw std::runtime_error("malformed request frame");
+  }
+  size_t frame_size =
+      kRequestHeaderSize + key_size + kNonceSize + kIvSize + payload_size;
+  if (buffer.size() < frame_size) {
+    return 0;
+  }
+  size_t pos = kRequestHeaderSize;
+  request->id = ReadU32(buffer);
+  request->op = static_cast<CtrOp>(op);
+  request->key.assign(buffer.substr(pos, key_size));
+  pos += key_size;
+  request->nonce.assign(buffer.substr(pos, kNonceSize));
+  pos += kNonceSize;
+  request->iv.assign(buffer.substr(pos, kIvSize));
+  pos += kIvSize;
+  request->payload.assign(buffer.substr(pos, payload_size));
+  return frame_size;
+}
+
+size_t DecodeResponse(std::string_view buffer, CtrResponse* response) {
+  if (buffer.size() < kResponseHeaderSize) {
+    return 0;
+  }
+  uint32_t payload_size = ReadU32(buffer.substr(5));
+  if (payload_size > kMaxPayloadSize) {
+    throw std::runtime_error("malformed response frame");
+  }
+  size_t frame_size = kResponseHeaderSize + payload_size;
+  if (buffer.size() < frame_size) {
+    return 0;
+  }
+  response->id = ReadU32(buffer);
+  response->ok = buffer[4] != 0;
+  response->payload.assign(buffer.substr(kResponseHeaderSize, payload_size));
+  return frame_size;
+}
+
+CtrBatcher::~CtrBatcher() { ClearContexts(); }
+
+void CtrBatcher::ClearContexts() {
+  for (auto& [key, ctx] : contexts_) {
+    EVP_CIPHER_CTX_free(ctx);
+  }
+  contexts_.clear();
+}
+
+EVP_CIPHER_CTX* CtrBatcher::ContextFor(const std::string& key) {
+  auto it = contexts_.find(key);
+  if (it != contexts_.end()) {
+    return it->second;
+  }
+  const EVP_CIPHER* cipher = EcbCipherFor(key.size());
+  if (cipher == nullptr) {
+    return nullptr;
+  }
+  if (contexts_.size() >= max_keys_) {
+    ClearContexts();
+  }
+  EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+  // Note: CTR use AES *encryption*, the key stream is ECB over counter blocks.
+  if (ctx == nullptr ||
+      EVP_EncryptInit_ex(ctx, cipher, nullptr,
+                         reinterpret_cast<const unsigned char*>(key.data()),
+                         nullptr) != 1) {
+    EVP_CIPHER_CTX_free(ctx);
+    return nullptr;
+  }
+  EVP_CIPHER_CTX_set_padding(ctx, 0);
+  contexts_.emplace(key, ctx);
+  return ctx;
+}
+
+std::vector<CtrResponse> CtrBatcher::Process(
+    const std::vector<CtrRequest>& batch) {
+  std::vector<CtrResponse> responses(batch.size());
+  // Group requests by key so that each key is used by one cipher call.
+  absl::flat_hash_map<std::string_view, std::vector<size_t>> by_key;
+  for (size_t i = 0; i < batch.size(); i++) {
+    const CtrRequest& request = batch[i];
+    responses[i].id = request.id;
+    responses[i].ok = false;
+    if (EcbCipherFor(request.key.size()) == nullptr) {
+      responses[i].payload = "invalid key size";
+    } else if (request.nonce.size() != kNonceSize ||
+               request.iv.size() != kIvSize) {
+      responses[i].payload = "invalid nonce/iv size";
+    } else if (request.payload.size() / kBlockSize >= UINT32_MAX) {
+      responses[i].payload = "payload too long";
+    } else {
+      by_key[request.key].push_back(i);
+    }
+  }
+
+  for (const auto& [key, indices] : by_key) {
+    size_t total_blocks = 0;
+    for (size_t i : indices) {
+      total_blocks += (batch[i].payload.size() + kBlockSize - 1) / kBlockSize;
+    }
+    EVP_CIPHER_CTX* ctx = ContextFor(batch[indices.front()].key);
+    if (ctx == nullptr) {
+      for (size_t i : indices) responses[i].payload = "cipher setup failed";
+      continue;
+    }
+
+    // Counter blocks of every request, back to back.
+    counter_blocks_.resize(total_blocks * kBlockSize);
+    char* block = counter_blocks_.data();
+    for (size_t i : indices) {
+      size_t blocks = (batch[i].payload.size() + kBlockSize - 1) / kBlockSize;
+      for (uint32_t counter = 1; counter <= blocks; counter++) {
+        std::copy(batch[i].nonce.begin(), batch[i].nonce.end(), block);
+        std::copy(batch[i].iv.begin(), batch[i].iv.end(), block + kNonceSize);
+        BigEndianSet(block + 12, counter);
+        block += kBlockSize;
+      }
+    }
+
+    key_stream_.resize(counter_blocks_.size() + kBlockSize);
+    int out_len = 0;
+    bool ok = counter_blocks_.empty() ||
+              EVP_EncryptUpdate(
+                  ctx, reinterpret_cast<unsigned char*>(key_stream_.data()),
+                  &out_len,
+                  reinterpret_cast<const unsigned char*>(
+                      counter_blocks_.data()),
+                  static_cast<int>(counter_blocks_.size())) == 1;
+
+    const char* stream = key_stream_.data();
+    for (size_t i : indices) {
+      const std::string& payload = batch[i].payload;
+      if (!ok) {
+        responses[i].payload = "cipher failed";
+        continue;
+      }
+      std::string& output = responses[i].payload;
+      FixedXorAppend(payload, std::string_view(stream, payload.size()),
+                     &output);
+      responses[i].ok = true;
+      stream += (payload.size() + kBlockSize - 1) / kBlockSize * kBlockSize;
+    }
+  }
+  return responses;
+}
+
+void CtrServer::Start() {
+  sockaddr_un addr = SocketAddress(options_.socket_path);
+  listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd_ < 0) {
+    throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+  }
+  unlink(options_.socket_path.c_str());
+  if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      listen(listen_fd_, SOMAXCONN) != 0) {
+    std::string error = std::strerror(errno);
+    close(listen_fd_);
+    listen_fd_ = -1;
+    throw std::runtime_error("bind " + options_.socket_path + ": " + error);
+  }
+  accept_thread_ = std::thread(&CtrServer::AcceptLoop, this);
+  dispatch_thread_ = std::thread(&CtrServer::DispatchLoop, this);
+}
+
+void CtrServer::Stop() {
+  if (listen_fd_ < 0 || stopping_.exchange(true)) {
+    return;
+  }
+  // Wake up every blocking accept/recv.
+  shutdown(listen_fd_, SHUT_RDWR);
+  queue_cv_.notify_all();
+  accept_thread_.join();
+  dispatch_thread_.join();
+  // No new connections can be added once the accept thread is gone.
+  std::unique_lock<std::mutex> lock(connections_mu_);
+  for (auto& [ptr, connection] : connections_) {
+    Close(connection.get());
+  }
+  connections_cv_.wait(lock, [this] { return connections_.empty(); });
+  lock.unlock();
+  close(listen_fd_);
+  unlink(options_.socket_path.c_str());
+}
+
+CtrServer::Connection::~Connection() { close(fd); }
+
+CtrServerStats CtrServer::GetStats() const {
+  uint64_t open;
+  {
+    std::lock_guard<std::mutex> lock(connections_mu_);
+    open = connections_.size();
+  }
+  return CtrServerStats{connection_count_, open,
+                        dropped_count_,    request_count_,
+                        batch_count_,      payload_bytes_};
+}
+
+void CtrServer::AcceptLoop() {
+  while (!stopping_) {
+    int fd = accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS ||
+          errno == ENOMEM) {
+        // Out of descriptors or memory for now; connections going away
+        // free them up again.
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        continue;
+      }
+      return;  // listening socket was shut down
+    }
+    auto connection = std::make_shared<Connection>(fd);
+    connection_count_++;
+    std::lock_guard<std::mutex> lock(connections_mu_);
+    if (stopping_) {
+      return;
+    }
+    connections_.emplace(connection.get(), connection);
+    std::thread(&CtrServer::ServeConnection, this, std::move(connection))
+        .detach();
+  }
+}
+
+void CtrServer::ServeConnection(std::shared_ptr<Connection> connection) {
+  std::thread writer(&CtrServer::WriteLoop, this, connection.get());
+  ReadLoop(connection);
+  Close(connection.get());
+  writer.join();
+  // The socket is closed as soon as the dispatcher dropped its pending
+  // requests as well. Nothing may touch `this` after the notification:
+  // Stop() returns once the last connection is gone.
+  std::lock_guard<std::mutex> lock(connections_mu_);
+  connections_.erase(connection.get());
+  connections_cv_.notify_all();
+}
+
+void CtrServer::Close(Connection* connection) {
+  {
+    std::lock_guard<std::mutex> lock(connection->mu);
+    if (!connection->closed) {
+      connection->closed = true;
+      shutdown(connection->fd, SHUT_RDWR);
+    }
+  }
+  connection->cv.notify_all();
+}
+
+void CtrServer::WriteLoop(Connection* connection) {
+  std::string sending;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(connection->mu);
+      connection->cv.wait(lock, [connection] {
+        return connection->closed || !connection->outbound.empty();
+      });
+      if (connection->closed) {
+        return;
+      }
+      sending.swap(connection->outbound);
+    }
+    try {
+      WriteAll(connection->fd, sending);
+    } catch (const std::runtime_error&) {
+      // Client went away, wake up the reader as well.
+      Close(connection);
+      return;
+    }
+    sending.clear();
+  }
+}
+
+void CtrServer::Enqueue(Connection* connection, std::string_view frames) {
+  {
+    std::lock_guard<std::mutex> lock(connection->mu);
+    if (connection->closed) {
+      return;
+    }
+    // A single response may exceed the bound, a backlog may not.
+    if (connection->outbound.empty() ||
+        connection->outbound.size() + frames.size() <=
+            options_.max_outbound_bytes) {
+      connection->outbound.append(frames);
+      connection->cv.notify_one();
+      return;
+    }
+  }
+  dropped_count_++;
+  Close(connection);
+}
+
+void CtrServer::ReadLoop(const std::shared_ptr<Connection>& connection) {
+  std::string buffer;
+  size_t pos = 0;
+  try {
+    while (ReadSome(connection->fd, &buffer)) {
+      std::vector<Pending> parsed;
+      size_t bytes = 0;
+      CtrRequest request;
+      while (size_t consumed = DecodeRequest(
+                 std::string_view(buffer).substr(pos), &request)) {
+        pos += consumed;
+        bytes += request.payload.size();
+        parsed.push_back(Pending{connection, std::move(request)});
+      }
+      buffer.erase(0, pos);
+      pos = 0;
+      if (parsed.empty()) continue;
+      std::lock_guard<std::mutex> lock(queue_mu_);
+      for (auto& pending : parsed) {
+        queue_.push_back(std::move(pending));
+      }
+      queued_bytes_ += bytes;
+      queue_cv_.notify_one();
+    }
+  } catch (const std::runtime_error&) {
+    // Malformed frame, drop the connection.
+  }
+}
+
+void CtrServer::DispatchLoop() {
+  CtrBatcher batcher;
+  std::vector<CtrRequest> requests;
+  std::vector<std::shared_ptr<Connection>> targets;
+  while (true) {
+    std::vector<Pending> batch;
+    {
+      std::unique_lock<std::mutex> lock(queue_mu_);
+      queue_cv_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+      if (stopping_) {
+        return;
+      }
+      // Linger a little so that concurrent small requests end up in the
+      // same batch.
+      queue_cv_.wait_for(lock, options_.max_batch_delay, [&] {
+        return stopping_ || queued_bytes_ >= options_.max_batch_bytes;
+      });
+      size_t bytes = 0;
+      while (!queue_.empty() && bytes < options_.max_batch_bytes) {
+        bytes += queue_.front().request.payload.size();
+        batch.push_back(std::move(queue_.front()));
+        queue_.pop_front();
+      }
+      queued_bytes_ -= bytes;
+    }
+
+    for (auto& pending : batch) {
+      payload_bytes_ += pending.request.payload.size();
+      requests.push_back(std::move(pending.request));
+      targets.push_back(std::move(pending.connection));
+    }
+    request_count_ += requests.size();
+    batch_count_++;
+    std::vector<CtrResponse> responses = batcher.Process(requests);
+
+    // Consecutive responses for the same connection go out in one write.
+    std::string frames;
+    for (size_t i = 0; i < responses.size(); i++) {
+      frames += EncodeResponse(responses[i]);
+      if (i + 1 < responses.size() && targets[i + 1] == targets[i]) {
+        continue;
+      }
+      Enqueue(targets[i].get(), frames);
+      frames.clear();
+    }
+    // Don't keep connections alive until the next batch.
+    requests.clear();
+    targets.clear();
+  }
+}
+
+std::unique_ptr<CtrClient> CtrClient::Connect(const std::string& socket_path) {
+  sockaddr_un addr = SocketAddress(socket_path);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 ||
+      connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    std::string error = std::strerror(errno);
+    if (fd >= 0) close(fd);
+    throw std::runtime_error("connect " + socket_path + ": " + error);
+  }
+  return std::make_unique<CtrClient>(fd);
+}
+
+CtrClient::~CtrClient() { close(fd_); }
+
+void CtrClient::Send(const CtrRequest& request) {
+  WriteAll(fd_, EncodeRequest(request));
+}
+
+CtrResponse CtrClient::Receive() {
+  CtrResponse response;
+  while (true) {
+    if (size_t consumed = DecodeResponse(buffer_, &response)) {
+      buffer_.erase(0, consumed);
+      return response;
+    }
+    if (!ReadSome(fd_, &buffer_)) {
+      throw std::runtime_error("connection closed");
+    }
+  }
+}
+
+}  // namespace cryptopals
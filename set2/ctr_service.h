@@ -0,0 +1,192 @@
+#ifndef CRYPTOPALS_SET2_CTR_SERVICE_H_
+#define CRYPTOPALS_SET2_CTR_SERVICE_H_
+
+#include <openssl/evp.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+
+namespace cryptopals {
+
+// A long-running local AES-CTR service. Clients send framed requests over a
+// Unix-domain socket; the server keeps expanded keys resident and coalesces
+// concurrent small requests into multi-block batches before running the
+// cipher. Responses carry the request id and may come back in any order, so
+// clients can keep many requests in flight on one connection.
+
+enum class CtrOp : uint8_t { ENCRYPT = 0, DECRYPT = 1 };
+
+struct CtrRequest {
+  uint32_t id;
+  CtrOp op;
+  std::string key;    // 128/192/256 bits
+  std::string nonce;  // 32 bits, see Aes::CtrEncrypt
+  std::string iv;     // 64 bits
+  std::string payload;
+};
+
+struct CtrResponse {
+  uint32_t id;
+  bool ok;
+  std::string payload;  // output of the cipher, or the error if !ok
+};
+
+// Wire format, integers are big-endian:
+//   request:  id u32 | op u8 | key_size u8 | payload_size u32 | key |
+//             nonce (4 bytes) | iv (8 bytes) | payload
+//   response: id u32 | ok u8 | payload_size u32 | payload
+std::string EncodeRequest(const CtrRequest& request);
+std::string EncodeResponse(const CtrResponse& response);
+
+// Parse one frame from the front of `buffer`. Return the number of bytes
+// consumed, or 0 if `buffer` does not hold a complete frame yet. Throw
+// std::runtime_error on a malformed frame.
+size_t DecodeRequest(std::string_view buffer, CtrRequest* request);
+size_t DecodeResponse(std::string_view buffer, CtrResponse* response);
+
+// Runs CTR over a batch of requests. Counter blocks of all requests sharing a
+// key are laid out in one buffer and encrypted with a single cipher call, so
+// OpenSSL can pipeline the blocks. Expanded keys stay resident across batches
+// (up to `max_keys`, then the key cache is reset). Not thread-safe.
+class CtrBatcher {
+ public:
+  explicit CtrBatcher(size_t max_keys = 1024) : max_keys_(max_keys) {}
+  ~CtrBatcher();
+  CtrBatcher(const CtrBatcher&) = delete;
+  CtrBatcher& operator=(const CtrBatcher&) = delete;
+
+  std::vector<CtrResponse> Process(const std::vector<CtrRequest>& batch);
+
+ private:
+  EVP_CIPHER_CTX* ContextFor(const std::string& key);
+  void ClearContexts();
+
+  const size_t max_keys_;
+  absl::flat_hash_map<std::string, EVP_CIPHER_CTX*> contexts_;
+  std::string counter_blocks_;  // reused across batches
+  std::string key_stream_;
+};
+
+struct CtrServerOptions {
+  std::string socket_path;
+  // A batch is dispatched once it holds this many payload bytes, or once
+  // `max_batch_delay` passed since its first request arrived.
+  size_t max_batch_bytes = 256 * 1024;
+  std::chrono::microseconds max_batch_delay{100};
+  // Every connection has its own writer, so a client that stops reading
+  // only holds up itself. Once more than this many response bytes wait for
+  // it, the connection is dropped.
+  size_t max_outbound_bytes = 64 * 1024 * 1024;
+};
+
+struct CtrServerStats {
+  uint64_t connections;
+  uint64_t open_connections;
+  uint64_t dropped_connections;  // for not reading their responses
+  uint64_t requests;
+  uint64_t batches;
+  uint64_t payload_bytes;
+};
+
+class CtrServer {
+ public:
+  explicit CtrServer(CtrServerOptions options) : options_(std::move(options)) {}
+  ~CtrServer() { Stop(); }
+  CtrServer(const CtrServer&) = delete;
+  CtrServer& operator=(const CtrServer&) = delete;
+
+  // Binds the socket and starts serving in background threads. Throws
+  // std::runtime_error if the socket cannot be set up.
+  void Start();
+  // Closes all connections and waits for all threads. Idempotent.
+  void Stop();
+
+  CtrServerStats GetStats() const;
+
+ private:
+  // Closes the socket once the reader, the writer and all pending requests
+  // are done with it.
+  struct Connection {
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection();
+    const int fd;
+    std::mutex mu;
+    std::condition_variable cv;
+    std::string outbound;  // encoded responses the writer has not taken yet
+    bool closed = false;
+  };
+  struct Pending {
+    std::shared_ptr<Connection> connection;
+    CtrRequest request;
+  };
+
+  void AcceptLoop();
+  // Runs on a detached thread per connection, which unregisters the
+  // connection when the client goes away.
+  void ServeConnection(std::shared_ptr<Connection> connection);
+  void ReadLoop(const std::shared_ptr<Connection>& connection);
+  void WriteLoop(Connection* connection);
+  // Hands `frames` to the writer of `connection`, or drops the connection if
+  // too much is waiting for it already.
+  void Enqueue(Connection* connection, std::string_view frames);
+  // Shuts the socket down, which wakes up its reader and writer.
+  static void Close(Connection* connection);
+  void DispatchLoop();
+
+  const CtrServerOptions options_;
+  int listen_fd_ = -1;
+  std::atomic<bool> stopping_{false};
+  std::thread accept_thread_;
+  std::thread dispatch_thread_;
+
+  mutable std::mutex connections_mu_;
+  std::condition_variable connections_cv_;  // signalled when one is removed
+  absl::flat_hash_map<Connection*, std::shared_ptr<Connection>> connections_;
+
+  std::mutex queue_mu_;
+  std::condition_variable queue_cv_;
+  std::deque<Pending> queue_;
+  size_t queued_bytes_ = 0;
+
+  std::atomic<uint64_t> connection_count_{0};
+  std::atomic<uint64_t> dropped_count_{0};
+  std::atomic<uint64_t> request_count_{0};
+  std::atomic<uint64_t> batch_count_{0};
+  std::atomic<uint64_t> payload_bytes_{0};
+};
+
+// Blocking client for CtrServer. Send and Receive may be used from two
+// different threads to keep requests in flight.
+class CtrClient {
+ public:
+  // Throws std::runtime_error if the server cannot be reached.
+  static std::unique_ptr<CtrClient> Connect(const std::string& socket_path);
+  explicit CtrClient(int fd) : fd_(fd) {}
+  ~CtrClient();
+  CtrClient(const CtrClient&) = delete;
+  CtrClient& operator=(const CtrClient&) = delete;
+
+  void Send(const CtrRequest& request);
+  // Blocks until the next response arrives. Throws std::runtime_error once
+  // the connection is closed.
+  CtrResponse Receive();
+
+ private:
+  int fd_;
+  std::string buffer_;
+};
+
+}  // namespace cryptopals
+
+#endif  // CRYPTOPALS_SET2_CTR_SERVICE_H_
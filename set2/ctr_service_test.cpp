@@ -0,0 +1,199 @@
+#include "ctr_service.h"
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+
+#include "aes.h"
+#include "gtest/gtest.h"
+#include "rand_util.h"
+
+namespace cryptopals {
+namespace {
+
+CtrRequest RandomRequest(uint32_t id, uint8_t payload_size) {
+  CtrRequest request;
+  request.id = id;
+  request.op = id % 2 ? CtrOp::DECRYPT : CtrOp::ENCRYPT;
+  request.key = util::RandStr(16);
+  request.nonce = util::RandStr(4);
+  request.iv = util::RandStr(8);
+  request.payload = util::RandStr(payload_size);
+  return request;
+}
+
+size_t OpenFdCount() {
+  size_t count = 0;
+  DIR* dir = opendir("/proc/self/fd");
+  if (dir == nullptr) return 0;
+  while (readdir(dir) != nullptr) count++;
+  closedir(dir);
+  return count;
+}
+
+TEST(CtrServiceTest, FrameCircling) {
+  CtrRequest request = RandomRequest(42, 20);
+  std::string frame = EncodeRequest(request);
+  CtrRequest decoded;
+  EXPECT_EQ(0, DecodeRequest(frame.substr(0, frame.size() - 1), &decoded));
+  EXPECT_EQ(frame.size(), DecodeRequest(frame + "tail", &decoded));
+  EXPECT_EQ(request.id, decoded.id);
+  EXPECT_EQ(request.op, decoded.op);
+  EXPECT_EQ(request.key, decoded.key);
+  EXPECT_EQ(request.nonce, decoded.nonce);
+  EXPECT_EQ(request.iv, decoded.iv);
+  EXPECT_EQ(request.payload, decoded.payload);
+
+  CtrResponse response{7, true, "payload"};
+  frame = EncodeResponse(response);
+  CtrResponse decoded_response;
+  EXPECT_EQ(frame.size(), DecodeResponse(frame, &decoded_response));
+  EXPECT_EQ(7, decoded_response.id);
+  EXPECT_TRUE(decoded_response.ok);
+  EXPECT_EQ("payload", decoded_response.payload);
+}
+
+TEST(CtrServiceTest, BatcherMatchesAes) {
+  std::vector<CtrRequest> batch;
+  for (uint32_t i = 0; i < 20; i++) {
+    batch.push_back(RandomRequest(i, i * 7));
+  }
+  // Same key with a different nonce in one batch
+  batch.push_back(batch[3]);
+  batch.back().id = 100;
+  batch.back().nonce = "abcd";
+  // Invalid key
+  batch.push_back(RandomRequest(101, 5));
+  batch.back().key = "short";
+
+  CtrBatcher batcher(/*max_keys=*/4);
+  for (int round = 0; round < 2; round++) {
+    auto responses = batcher.Process(batch);
+    ASSERT_EQ(batch.size(), responses.size());
+    for (size_t i = 0; i + 1 < batch.size(); i++) {
+      EXPECT_EQ(batch[i].id, responses[i].id);
+      EXPECT_TRUE(responses[i].ok);
+      EXPECT_EQ(Aes::CtrEncrypt(batch[i].payload, batch[i].key,
+                                batch[i].nonce, batch[i].iv),
+                responses[i].payload);
+    }
+    EXPECT_FALSE(responses.back().ok);
+  }
+}
+
+TEST(CtrServiceTest, ServerRoundTrip) {
+  CtrServerOptions options;
+  options.socket_path = ::testing::TempDir() + "ctr_service_test.sock";
+  CtrServer server(options);
+  server.Start();
+
+  constexpr int kClients = 4;
+  constexpr int kRequestsPerClient = 50;
+  std::vector<std::thread> clients;
+  for (int c = 0; c < kClients; c++) {
+    clients.emplace_back([&options]() {
+      auto client = CtrClient::Connect(options.socket_path);
+      std::vector<CtrRequest> requests;
+      // Keep all requests in flight before reading any response.
+      for (uint32_t i = 0; i < kRequestsPerClient; i++) {
+        requests.push_back(RandomRequest(i, i));
+        client->Send(requests.back());
+      }
+      for (int i = 0; i < kRequestsPerClient; i++) {
+        CtrResponse response = client->Receive();
+        ASSERT_LT(response.id, requests.size());
+        const CtrRequest& request = requests[response.id];
+        EXPECT_TRUE(response.ok);
+        EXPECT_EQ(Aes::CtrEncrypt(request.payload, request.key, request.nonce,
+                                  request.iv),
+                  response.payload);
+      }
+    });
+  }
+  for (auto& client : clients) client.join();
+  server.Stop();
+
+  auto stats = server.GetStats();
+  EXPECT_EQ(kClients, stats.connections);
+  EXPECT_EQ(kClients * kRequestsPerClient, stats.requests);
+  EXPECT_LE(stats.batches, stats.requests);
+}
+
+// Connections of clients that went away must not pile up until Stop().
+TEST(CtrServiceTest, ShortLivedClients) {
+  CtrServerOptions options;
+  options.socket_path = ::testing::TempDir() + "ctr_service_test_short.sock";
+  CtrServer server(options);
+  server.Start();
+  const size_t fds = OpenFdCount();
+
+  constexpr int kClients = 300;
+  for (uint32_t i = 0; i < kClients; i++) {
+    auto client = CtrClient::Connect(options.socket_path);
+    client->Send(RandomRequest(i, 16));
+    EXPECT_EQ(i, client->Receive().id);
+  }
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (server.GetStats().open_connections > 0 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  auto stats = server.GetStats();
+  EXPECT_EQ(kClients, stats.connections);
+  EXPECT_EQ(0, stats.open_connections);
+  // The dispatcher may still hold the last connection for a moment.
+  while (OpenFdCount() > fds && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(fds, OpenFdCount());
+  server.Stop();
+}
+
+// A client that sends but never reads must not hold up the others, and is
+// dropped once its backlog exceeds max_outbound_bytes.
+TEST(CtrServiceTest, SlowReaderIsDropped) {
+  CtrServerOptions options;
+  options.socket_path = ::testing::TempDir() + "ctr_service_test_slow.sock";
+  options.max_outbound_bytes = 1024 * 1024;
+  CtrServer server(options);
+  server.Start();
+
+  auto slow = CtrClient::Connect(options.socket_path);
+  CtrRequest big = RandomRequest(0, 0);
+  big.payload = util::RandStr(64 * 1024);
+  try {
+    for (int i = 0; i < 256; i++) {  // 16 MiB of responses
+      slow->Send(big);
+    }
+  } catch (const std::runtime_error&) {
+    // Dropped before it finished sending.
+  }
+
+  auto client = CtrClient::Connect(options.socket_path);
+  for (uint32_t i = 0; i < 50; i++) {
+    CtrRequest request = RandomRequest(i, 100);
+    client->Send(request);
+    CtrResponse response = client->Receive();
+    EXPECT_EQ(i, response.id);
+    EXPECT_EQ(Aes::CtrEncrypt(request.payload, request.key, request.nonce,
+                              request.iv),
+              response.payload);
+  }
+
+  // The slow client gets what was sent before the drop, then EOF.
+  int received = 0;
+  EXPECT_THROW(
+      while (true) {
+        slow->Receive();
+        received++;
+      },
+      std::runtime_error);
+  EXPECT_LT(received, 256);
+  EXPECT_EQ(1, server.GetStats().dropped_connections);
+  server.Stop();
+}
+
+}  // namespace
+}  // namespace cryptopals
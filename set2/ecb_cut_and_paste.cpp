@@ -6,6 +6,7 @@
 
 #include <cmath>
 #include <fstream>
+#include <stdexcept>
 
 #include "aes.h"
 #include "padding.h"
@@ -20,14 +21,17 @@ class ProfileOracle {
     std::string escaped = absl::StrReplaceAll(email, {{"&", ""}, {"=", ""}});
     std::string encoded =
         absl::Substitute("email=$0&uid=10&role=user", escaped);
-    auto padded = Padding::Pkcs7Encode(encoded, 16);
-    return Aes::EcbEncrypt(padded, random_key_);
+    Padding::Pkcs7Pad(&encoded, 16);
+    return Aes::EcbEncrypt(encoded, random_key_);
   }
 
   std::string ParseRole(std::string_view ciphertext) {
     auto plaintext = Aes::EcbDecrypt(ciphertext, random_key_);
-    auto profile = Padding::Pkcs7Decode(plaintext);
-    std::vector<std::string> parts = absl::StrSplit(profile, '&');
+    auto profile = Padding::Pkcs7Unpad(plaintext, 16);
+    if (!profile) {
+      throw std::runtime_error("Invalid padding");
+    }
+    std::vector<std::string> parts = absl::StrSplit(*profile, '&');
     std::vector<std::string> role = absl::StrSplit(parts[2], '=');
     return role[1];
   }
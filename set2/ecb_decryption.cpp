@@ -1,12 +1,20 @@
-#include <absl/strings/escaping.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/str_cat.h>
 #include <gtest/gtest.h>
 
-#include <cstdlib>
-#include <ctime>
+#include <chrono>
 #include <exception>
-#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
+#include "../util/codec.h"
+#include "../util/mapped_file.h"
 #include "aes.h"
+#include "async_oracle.h"
+#include "caching_oracle.h"
+#include "encryption_oracle.h"
+#include "instrumented_oracle.h"
 #include "padding.h"
 #include "rand_util.h"
 
@@ -17,30 +25,24 @@ constexpr size_t kBlockSize = 16;  // AES 128 bit block.
 constexpr std::string_view kUnknownStrFilename = "unknown_str.txt";
 
 std::string ReadBase64File(std::string_view filename) {
-  std::ifstream file(filename.data(), std::ios::in | std::ios::binary);
-  assert(file.is_open());
-  std::stringstream ss;
-  ss << file.rdbuf();
-  std::string content_base64 = ss.str();
-  file.close();
+  const auto file = util::MappedFile::OpenData(filename);
   std::string result;
-  assert(absl::Base64Unescape(content_base64, &result));
+  if (!util::Base64DecodeAppend(file.data(), &result)) {
+    throw std::runtime_error("Invalid base64 in " + std::string(filename));
+  }
   return result;
 }
 
-class EncryptionOracle {
- public:
-  virtual std::string Encrypt(std::string_view input) = 0;
-};
-
 class EncryptionOracleEasy : public EncryptionOracle {
  public:
   explicit EncryptionOracleEasy(std::string_view target_bytes)
       : target_bytes_(target_bytes) {}
 
   std::string Encrypt(std::string_view input) override {
-    auto padded =
-        Padding::Pkcs7Encode(absl::StrCat(input, target_bytes_), kBlockSize);
+    std::string padded;
+    padded.reserve(input.size() + target_bytes_.size() + kBlockSize);
+    padded.append(input).append(target_bytes_);
+    Padding::Pkcs7Pad(&padded, kBlockSize);
     return Aes::EcbEncrypt(padded, random_key_);
   }
 
@@ -128,9 +130,70 @@ TEST(EcbDecryptionEasy, DecryptTargetBytes) {
   auto unknown_str = ReadBase64File(kUnknownStrFilename);
   EncryptionOracleEasy oracle(unknown_str);
   auto target_size = GuessTargetBytesSize(&oracle, 0);
-  auto target_bytes = DecryptTargetBytes(&oracle, 0, target_size);
+  InstrumentedOracle instrumented(&oracle);
+  auto target_bytes = DecryptTargetBytes(&instrumented, 0, target_size);
   EXPECT_EQ(target_bytes, unknown_str);
   std::cout << "unknown_str content is:\n" << target_bytes << std::endl;
+  std::cout << "one query per candidate: "
+            << instrumented.Stats().ToJson(target_bytes.size()) << std::endl;
+}
+
+// Same result as DecryptTargetBytes, but all 256 candidates for byte i go
+// into a single query, followed by the stimulus which puts byte i at the end
+// of a block:
+//   prefix_comp | known(15) c=0 | ... | known(15) c=255 | stimulus
+// The candidate blocks come back in order in front of the target blocks, so
+// a table from ciphertext block to candidate byte finds the match. That is
+// one oracle call per byte instead of up to 257.
+std::string DecryptTargetBytesBatched(EncryptionOracle* oracle,
+                                      size_t prefix_size, size_t target_size) {
+  std::string prefix_comp((kBlockSize - prefix_size % kBlockSize) % kBlockSize,
+                          'x');
+  const size_t prefix_blk_size = prefix_size + prefix_comp.size();
+  const size_t target_blk_pos = prefix_blk_size + 256 * kBlockSize;
+  // 'A' padding followed by everything guessed so far; the candidate blocks
+  // take their first 15 bytes from the end of it.
+  std::string known(kBlockSize - 1, 'A');
+  std::string query;
+  absl::flat_hash_map<std::string_view, uint8_t> dictionary;
+  dictionary.reserve(256);
+  for (size_t i = 0; i < target_size; i++) {
+    std::string_view window =
+        std::string_view(known).substr(known.size() - (kBlockSize - 1));
+    query = prefix_comp;
+    for (int c = 0; c < 256; c++) {
+      query.append(window).push_back(static_cast<char>(c));
+    }
+    query.append(kBlockSize - 1 - i % kBlockSize, 'A');
+    const std::string response = oracle->Encrypt(query);
+
+    std::string_view blocks(response);
+    dictionary.clear();
+    for (int c = 0; c < 256; c++) {
+      dictionary.emplace(
+          blocks.substr(prefix_blk_size + c * kBlockSize, kBlockSize), c);
+    }
+    auto it = dictionary.find(blocks.substr(
+        target_blk_pos + i / kBlockSize * kBlockSize, kBlockSize));
+    if (it == dictionary.end()) {
+      throw std::runtime_error("No candidate matches target byte " +
+                               std::to_string(i));
+    }
+    known += static_cast<char>(it->second);
+  }
+  return known.substr(kBlockSize - 1);
+}
+
+TEST(EcbDecryptionEasy, DecryptTargetBytesBatched) {
+  auto unknown_str = ReadBase64File(kUnknownStrFilename);
+  EncryptionOracleEasy oracle(unknown_str);
+  InstrumentedOracle instrumented(&oracle);
+  auto target_bytes =
+      DecryptTargetBytesBatched(&instrumented, 0, unknown_str.size());
+  EXPECT_EQ(target_bytes, unknown_str);
+  OracleStats stats = instrumented.Stats();
+  EXPECT_EQ(unknown_str.size(), stats.queries);
+  std::cout << "batched: " << stats.ToJson(target_bytes.size()) << std::endl;
 }
 
 // Quote from Internet:
@@ -145,15 +208,17 @@ class EncryptionOracleHard : public EncryptionOracle {
  public:
   explicit EncryptionOracleHard(std::string_view target_bytes)
       : target_bytes_(target_bytes) {
-    std::srand(std::time(nullptr));
-    auto prefix_len_ = std::rand() % 32 + 1;  // Use prefix of length [1, 32]
-    random_prefix_ = util::RandStr(prefix_len_);
+    // Use prefix of length [1, 32]
+    random_prefix_ = util::RandStr(util::RandUniform(1, 32));
     random_key_ = util::RandStr(kBlockSize);
   }
 
   std::string Encrypt(std::string_view input) override {
-    auto padded = Padding::Pkcs7Encode(
-        absl::StrCat(random_prefix_, input, target_bytes_), kBlockSize);
+    std::string padded;
+    padded.reserve(random_prefix_.size() + input.size() +
+                   target_bytes_.size() + kBlockSize);
+    padded.append(random_prefix_).append(input).append(target_bytes_);
+    Padding::Pkcs7Pad(&padded, kBlockSize);
     return Aes::EcbEncrypt(padded, random_key_);
   }
 
@@ -163,6 +228,17 @@ class EncryptionOracleHard : public EncryptionOracle {
   std::string random_key_;
 };
 
+// Offset of the first block of `response` equal to the block after it.
+size_t FindRepeatedBlock(std::string_view response) {
+  for (size_t i = 0; i + 2 * kBlockSize <= response.size(); i += kBlockSize) {
+    if (response.substr(i, kBlockSize) ==
+        response.substr(i + kBlockSize, kBlockSize)) {
+      return i;
+    }
+  }
+  throw std::runtime_error("No repeated block in response.");
+}
+
 // This would report wrong result if:
 // a. There exist two consecutive blocks with same content (ignorable with
 //    random prefix)
@@ -173,19 +249,11 @@ class EncryptionOracleHard : public EncryptionOracle {
 // The impl looks (a little) complicated because duplicated blocks in suffix
 // is considered.
 size_t GuessPrefixSizeInternal(EncryptionOracle* oracle, char ch) {
-  size_t dup_blk_pos;
   // 47 repeating chars will for sure produce two duplicated blocks no matter
   // what the prefix_size is.
   std::string stimulus(3 * kBlockSize - 1, ch);
-  auto response = oracle->Encrypt(stimulus);
-  for (int i = 0; i < response.size() - 2 * kBlockSize; i += kBlockSize) {
-    auto cur_blk = response.substr(i, kBlockSize);
-    auto nxt_blk = response.substr(i + kBlockSize, kBlockSize);
-    if (cur_blk == nxt_blk) {
-      dup_blk_pos = i;
-      break;
-    }
-  }
+  size_t dup_blk_pos = FindRepeatedBlock(oracle->Encrypt(stimulus));
+  std::string response;
   for (int i = 0; i < kBlockSize; i++) {
     stimulus.assign(2 * kBlockSize + i, ch);
     response = oracle->Encrypt(stimulus);
@@ -214,6 +282,79 @@ size_t GuessPrefixSize(EncryptionOracle* oracle) {
   }
 }
 
+// GuessPrefixSize sends its probes one after another, but none of them
+// depends on an earlier response. Here the probes for 'A', 'B' and 'C' are
+// all put in flight at once and evaluated afterwards, so prefix detection
+// costs one round trip instead of up to 51.
+size_t GuessPrefixSizeAsync(AsyncEncryptionOracle* oracle) {
+  constexpr size_t kProbes = kBlockSize + 1;
+  const std::string chars = "ABC";
+  std::vector<std::string> stimuli;
+  for (char ch : chars) {
+    stimuli.emplace_back(3 * kBlockSize - 1, ch);
+    for (size_t i = 0; i < kBlockSize; i++) {
+      stimuli.emplace_back(2 * kBlockSize + i, ch);
+    }
+  }
+  const auto responses = oracle->EncryptAll(std::move(stimuli));
+  // Same evaluation as GuessPrefixSizeInternal.
+  auto guess = [&responses](size_t c) {
+    const std::string* probes = &responses[c * kProbes];
+    size_t dup_blk_pos = FindRepeatedBlock(probes[0]);
+    for (size_t i = 0; i < kBlockSize; i++) {
+      std::string_view response = probes[1 + i];
+      if (response.substr(dup_blk_pos, kBlockSize) ==
+          response.substr(dup_blk_pos + kBlockSize, kBlockSize)) {
+        return dup_blk_pos - i;
+      }
+    }
+    throw std::runtime_error("Should not reach here.");
+  };
+  size_t guess_a = guess(0);
+  size_t guess_b = guess(1);
+  return guess_a == guess_b ? guess_a : guess(2);
+}
+
+// DecryptTargetBytes with the queries for one byte in flight together: the
+// target block and the 256 candidates only depend on the bytes recovered
+// before. All 257 queries are sent (no early exit), but a byte costs one
+// round trip when the oracle serves them concurrently.
+std::string DecryptTargetBytesAsync(AsyncEncryptionOracle* oracle,
+                                    size_t prefix_size, size_t target_size) {
+  std::string prefix_comp((kBlockSize - prefix_size % kBlockSize) % kBlockSize,
+                          'x');
+  const size_t prefix_blk_size = prefix_size + prefix_comp.size();
+  std::string known(kBlockSize - 1, 'A');
+  for (size_t i = 0; i < target_size; i++) {
+    std::string_view window =
+        std::string_view(known).substr(known.size() - (kBlockSize - 1));
+    std::vector<std::string> stimuli;
+    stimuli.reserve(257);
+    stimuli.push_back(prefix_comp +
+                      std::string(kBlockSize - 1 - i % kBlockSize, 'A'));
+    for (int c = 0; c < 256; c++) {
+      stimuli.push_back(prefix_comp);
+      stimuli.back().append(window).push_back(static_cast<char>(c));
+    }
+    const auto responses = oracle->EncryptAll(std::move(stimuli));
+    std::string_view target = std::string_view(responses[0]).substr(
+        prefix_blk_size + i / kBlockSize * kBlockSize, kBlockSize);
+    int found = -1;
+    for (int c = 0; c < 256 && found < 0; c++) {
+      if (std::string_view(responses[1 + c]).substr(prefix_blk_size,
+                                                    kBlockSize) == target) {
+        found = c;
+      }
+    }
+    if (found < 0) {
+      throw std::runtime_error("No candidate matches target byte " +
+                               std::to_string(i));
+    }
+    known += static_cast<char>(found);
+  }
+  return known.substr(kBlockSize - 1);
+}
+
 TEST(DetectPrefixSizeTest, DuplicatedBlockInTargetBytes) {
   std::string target_bytes(3 * kBlockSize, 'x');
   EncryptionOracleHard oracle(target_bytes);
@@ -243,5 +384,68 @@ TEST(EcbDecryptionHard, DecryptTargetBytes) {
   EXPECT_EQ(target_bytes, unknown_str);
 }
 
+TEST(EcbDecryptionHard, DecryptTargetBytesBatched) {
+  auto unknown_str = ReadBase64File(kUnknownStrFilename);
+  EncryptionOracleHard oracle(unknown_str);
+  auto prefix_size = GuessPrefixSize(&oracle);
+  auto target_size = GuessTargetBytesSize(&oracle, prefix_size);
+  InstrumentedOracle instrumented(&oracle);
+  auto target_bytes =
+      DecryptTargetBytesBatched(&instrumented, prefix_size, target_size);
+  EXPECT_EQ(target_bytes, unknown_str);
+  EXPECT_EQ(target_size, instrumented.Stats().queries);
+}
+
+// The probes of GuessPrefixSize and GuessTargetBytesSize and the stimuli of
+// DecryptTargetBytes repeat (e.g. the same 'A' padding for byte i and byte
+// i + 16), so a cache in front of the oracle saves a share of the queries.
+TEST(EcbDecryptionHard, DecryptTargetBytesCached) {
+  auto unknown_str = ReadBase64File(kUnknownStrFilename);
+  EncryptionOracleHard oracle(unknown_str);
+  InstrumentedOracle instrumented(&oracle);
+  CachingOracle cached(&instrumented, 1 << 20);
+  auto prefix_size = GuessPrefixSize(&cached);
+  EXPECT_EQ(prefix_size, oracle.random_prefix_.size());
+  auto target_size = GuessTargetBytesSize(&cached, prefix_size);
+  auto target_bytes = DecryptTargetBytes(&cached, prefix_size, target_size);
+  EXPECT_EQ(target_bytes, unknown_str);
+
+  CacheStats stats = cached.Stats();
+  std::cout << stats.Report() << std::endl;
+  EXPECT_GE(stats.hits, target_size - kBlockSize);
+  EXPECT_EQ(stats.misses, instrumented.Stats().queries);
+}
+
+// Against a stand-in with a remote-like round trip, keeping many queries in
+// flight hides most of the latency.
+TEST(EcbDecryptionHard, DecryptTargetBytesAsync) {
+  constexpr auto kLatency = std::chrono::microseconds(200);
+  constexpr size_t kConcurrency = 64;
+  auto unknown_str = ReadBase64File(kUnknownStrFilename);
+  EncryptionOracleHard oracle(unknown_str);
+  LatencyOracle remote(&oracle, kLatency, kConcurrency);
+  InstrumentedOracle instrumented(&remote);
+  ConcurrentOracle async_oracle(&instrumented, kConcurrency);
+
+  const auto start = std::chrono::steady_clock::now();
+  auto prefix_size = GuessPrefixSizeAsync(&async_oracle);
+  EXPECT_EQ(prefix_size, oracle.random_prefix_.size());
+  auto target_size = GuessTargetBytesSize(&instrumented, prefix_size);
+  auto target_bytes =
+      DecryptTargetBytesAsync(&async_oracle, prefix_size, target_size);
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(target_bytes, unknown_str);
+
+  OracleStats stats = instrumented.Stats();
+  const double sequential = stats.queries * kLatency.count() * 1e-6;
+  std::cout << stats.queries << " queries in " << elapsed.count()
+            << " s, one at a time would take at least " << sequential << " s"
+            << std::endl;
+  // Wall time depends on the machine, so only the overlap is checked.
+  EXPECT_GE(remote.peak_concurrency(), kConcurrency / 2);
+  EXPECT_LE(remote.peak_concurrency(), kConcurrency);
+}
+
 }  // namespace
 }  // namespace cryptopals
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef CRYPTOPALS_SET2_ENCRYPTION_ORACLE_H_
+#define CRYPTOPALS_SET2_ENCRYPTION_ORACLE_H_
+
+#include <string>
+#include <string_view>
+
+namespace cryptopals {
+
+// A chosen-plaintext oracle: the attacks only get to see the ciphertext of
+// inputs of their choosing. Decorators (instrumentation, caching) wrap an
+// oracle through this same interface.
+class EncryptionOracle {
+ public:
+  virtual ~EncryptionOracle() = default;
+  virtual std::string Encrypt(std::string_view input) = 0;
+};
+
+}  // namespace cryptopals
+
+#endif  // CRYPTOPALS_SET2_ENCRYPTION_ORACLE_H_
@@ -0,0 +1,494 @@
+#include "file_cipher.h"
+
+#include <fcntl.h>
+#include <openssl/aes.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../set1/fixed_xor.h"
+#include "../util/parallel.h"
+#include "padding.h"
+
+namespace cryptopals {
+
+namespace {
+
+constexpr size_t kBlockSize = 16;  // 128-bit block
+
+[[noreturn]] void ThrowErrno(const std::string& what) {
+  throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+bool IsPadded(FileCipherMode mode) { return mode != FileCipherMode::CTR; }
+
+// AES_KEY plus everything needed to process any range of blocks of a message.
+class BlockCipher {
+ public:
+  explicit BlockCipher(const FileCipherOptions& options)
+      : mode_(options.mode), decrypt_(options.decrypt) {
+    bool use_decrypt_key = decrypt_ && mode_ != FileCipherMode::CTR;
+    const auto* key =
+        reinterpret_cast<const unsigned char*>(options.key.data());
+    int bits = static_cast<int>(options.key.size()) * 8;
+    int res = use_decrypt_key ? AES_set_decrypt_key(key, bits, &aes_key_)
+                              : AES_set_encrypt_key(key, bits, &aes_key_);
+    if (res != 0) {
+      throw std::invalid_argument("invalid key size");
+    }
+    size_t iv_size = mode_ == FileCipherMode::CBC   ? kBlockSize
+                     : mode_ == FileCipherMode::CTR ? 12
+                                                    : 0;
+    if (options.iv.size() != iv_size) {
+      throw std::invalid_argument("invalid iv size");
+    }
+    std::copy(options.iv.begin(), options.iv.end(), iv_);
+  }
+
+  // CBC encryption needs the previous output block, nothing else does.
+  bool parallel() const { return mode_ != FileCipherMode::CBC || decrypt_; }
+
+  const uint8_t* iv() const { return iv_; }
+
+  // Processes `size` bytes starting from block `first_block` of the message.
+  // `size` is block aligned except for the final CTR block. For CBC, `chain`
+  // is the ciphertext block preceding `in`/`out`, i.e. the iv for block 0.
+  void Process(const uint8_t* in, uint8_t* out, size_t size,
+               uint64_t first_block, const uint8_t* chain) const {
+    switch (mode_) {
+      case FileCipherMode::ECB:
+        for (size_t i = 0; i < size; i += kBlockSize) {
+          if (decrypt_) {
+            AES_decrypt(in + i, out + i, &aes_key_);
+          } else {
+            AES_encrypt(in + i, out + i, &aes_key_);
+          }
+        }
+        break;
+      case FileCipherMode::CBC:
+        for (size_t i = 0; i < size; i += kBlockSize) {
+          uint8_t block[kBlockSize];
+          if (decrypt_) {
+            AES_decrypt(in + i, block, &aes_key_);
+            XorBytes(out + i, block, chain, kBlockSize);
+            chain = in + i;
+          } else {
+            XorBytes(block, in + i, chain, kBlockSize);
+            AES_encrypt(block, out + i, &aes_key_);
+            chain = out + i;
+          }
+        }
+        break;
+      case FileCipherMode::CTR: {
+        unsigned char ctr_block[kBlockSize];
+        uint8_t key_stream[kBlockSize];
+        std::copy(iv_, iv_ + 12, ctr_block);
+        // Counter starts from 1, details see Aes::CtrEncrypt.
+        auto counter = static_cast<uint32_t>(first_block + 1);
+        for (size_t i = 0; i < size; i += kBlockSize, counter++) {
+          ctr_block[12] = counter >> 24u;
+          ctr_block[13] = counter >> 16u;
+          ctr_block[14] = counter >> 8u;
+          ctr_block[15] = counter;
+          AES_encrypt(ctr_block, key_stream, &aes_key_);
+          size_t n = std::min(kBlockSize, size - i);
+          XorBytes(out + i, in + i, key_stream, n);
+        }
+        break;
+      }
+    }
+  }
+
+ private:
+  FileCipherMode mode_;
+  bool decrypt_;
+  AES_KEY aes_key_;
+  uint8_t iv_[kBlockSize] = {};
+};
+
+// Runs `cipher` over `size` bytes which start at block `first_block` of the
+// message, spread over the thread pool whenever the mode allows it.
+void ProcessRange(const BlockCipher& cipher, const uint8_t* in, uint8_t* out,
+                  size_t size, uint64_t first_block, const uint8_t* chain,
+                  const FileCipherOptions& options) {
+  if (!cipher.parallel()) {
+    cipher.Process(in, out, size, first_block, chain);
+    return;
+  }
+  size_t blocks = (size + kBlockSize - 1) / kBlockSize;
+  size_t grain = std::max<size_t>(options.chunk_size / kBlockSize, 1);
+  util::ParallelFor(
+      blocks, grain,
+      [&](size_t begin, size_t end) {
+        size_t offset = begin * kBlockSize;
+        size_t len = std::min(end * kBlockSize, size) - offset;
+        cipher.Process(in + offset, out + offset, len, first_block + begin,
+                       begin == 0 ? chain : in + offset - kBlockSize);
+      },
+      options.threads);
+}
+
+// Checks the PKCS#7 padding at the end of `data` and returns its length.
+size_t PaddingLength(const uint8_t* data, size_t size) {
+  std::string_view padded(reinterpret_cast<const char*>(data), size);
+  auto unpadded = Padding::Pkcs7Unpad(padded, kBlockSize);
+  if (!unpadded) {
+    throw std::runtime_error("invalid PKCS#7 padding");
+  }
+  return size - unpadded->size();
+}
+
+void CheckCounterRange(uint64_t size, FileCipherMode mode) {
+  // 32-bit counter starting from 1
+  if (mode == FileCipherMode::CTR && size / kBlockSize >= UINT32_MAX) {
+    throw std::invalid_argument("message too long for a 32-bit CTR counter");
+  }
+}
+
+class ScopedFd {
+ public:
+  explicit ScopedFd(int fd) : fd_(fd) {}
+  ~ScopedFd() {
+    if (fd_ >= 0) close(fd_);
+  }
+  ScopedFd(const ScopedFd&) = delete;
+  ScopedFd& operator=(const ScopedFd&) = delete;
+  int get() const { return fd_; }
+  int release() {
+    int fd = fd_;
+    fd_ = -1;
+    return fd;
+  }
+
+ private:
+  int fd_;
+};
+
+// Opens `path` as the output for the input `in_fd`. The file is truncated
+// only after checking it is not the input itself (same path, hard link or
+// symlink), which truncating would destroy before it is read.
+int OpenOutput(const std::string& path, int in_fd, int flags) {
+  int fd = open(path.c_str(), flags | O_CREAT, 0644);
+  if (fd < 0) ThrowErrno("open " + path);
+  ScopedFd out(fd);
+  struct stat in_st, out_st;
+  if (fstat(in_fd, &in_st) != 0) ThrowErrno("stat input");
+  if (fstat(fd, &out_st) != 0) ThrowErrno("stat " + path);
+  if (S_ISREG(out_st.st_mode) && in_st.st_dev == out_st.st_dev &&
+      in_st.st_ino == out_st.st_ino) {
+    throw std::invalid_argument("output " + path + " is the input file");
+  }
+  if (S_ISREG(out_st.st_mode) && ftruncate(fd, 0) != 0) {
+    ThrowErrno("truncate " + path);
+  }
+  return out.release();
+}
+
+class Mapping {
+ public:
+  Mapping(int fd, size_t size, bool writable) : size_(size) {
+    int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* addr = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+    if (addr != MAP_FAILED) {
+      data_ = static_cast<uint8_t*>(addr);
+      madvise(data_, size_, MADV_SEQUENTIAL);
+    }
+  }
+  ~Mapping() {
+    if (data_ != nullptr) munmap(data_, size_);
+  }
+  Mapping(const Mapping&) = delete;
+  Mapping& operator=(const Mapping&) = delete;
+  uint8_t* data() const { return data_; }
+
+ private:
+  uint8_t* data_ = nullptr;
+  size_t size_;
+};
+
+// Single-producer single-consumer queue holding at most `capacity` items.
+// Close() wakes everyone up: Push then fails, Pop drains what is left.
+template <class T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity) : capacity_(capacity) {}
+
+  bool Push(T item) {
+    std::unique_lock<std::mutex> lock(mu_);
+    not_full_.wait(lock, [&] { return closed_ || items_.size() < capacity_; });
+    if (closed_) {
+      return false;
+    }
+    items_.push_back(std::move(item));
+    not_empty_.notify_one();
+    return true;
+  }
+
+  std::optional<T> Pop() {
+    std::unique_lock<std::mutex> lock(mu_);
+    not_empty_.wait(lock, [&] { return closed_ || !items_.empty(); });
+    if (items_.empty()) {
+      return std::nullopt;
+    }
+    T item = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return item;
+  }
+
+  void Close() {
+    std::lock_guard<std::mutex> lock(mu_);
+    closed_ = true;
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+
+ private:
+  const size_t capacity_;
+  std::mutex mu_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::deque<T> items_;
+  bool closed_ = false;
+};
+
+struct Chunk {
+  std::vector<uint8_t> data;
+  bool last = false;
+};
+
+size_t ReadFull(int fd, uint8_t* buf, size_t size) {
+  size_t total = 0;
+  while (total < size) {
+    ssize_t n = read(fd, buf + total, size - total);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) ThrowErrno("read");
+    if (n == 0) break;
+    total += n;
+  }
+  return total;
+}
+
+void WriteFull(int fd, const uint8_t* buf, size_t size) {
+  size_t total = 0;
+  while (total < size) {
+    ssize_t n = write(fd, buf + total, size - total);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) ThrowErrno("write");
+    total += n;
+  }
+}
+
+FileCipherOptions Normalize(const FileCipherOptions& options) {
+  FileCipherOptions normalized = options;
+  normalized.chunk_size =
+      std::max(kBlockSize, options.chunk_size / kBlockSize * kBlockSize);
+  return normalized;
+}
+
+}  // namespace
+
+uint64_t CipherStream(int in_fd, int out_fd,
+                      const FileCipherOptions& raw_options) {
+  const FileCipherOptions options = Normalize(raw_options);
+  const BlockCipher cipher(options);
+  const bool padded = IsPadded(options.mode);
+  constexpr size_t kQueueDepth = 4;
+  BoundedQueue<Chunk> read_queue(kQueueDepth);
+  BoundedQueue<Chunk> write_queue(kQueueDepth);
+  std::exception_ptr reader_error, writer_error;
+  uint64_t written = 0;
+
+  // Reads one chunk ahead so that the final chunk is known before it gets
+  // ciphered, which is where padding is added or removed.
+  std::thread reader([&] {
+    try {
+      auto read_chunk = [&]() {
+        Chunk chunk;
+        chunk.data.resize(options.chunk_size);
+        chunk.data.resize(
+            ReadFull(in_fd, chunk.data.data(), options.chunk_size));
+        return chunk;
+      };
+      Chunk current = read_chunk();
+      while (current.data.size() == options.chunk_size) {
+        Chunk next = read_chunk();
+        if (next.data.empty()) break;
+        if (!read_queue.Push(std::move(current))) return;
+        current = std::move(next);
+      }
+      current.last = true;
+      read_queue.Push(std::move(current));
+    } catch (...) {
+      reader_error = std::current_exception();
+    }
+    read_queue.Close();
+  });
+
+  std::thread writer([&] {
+    try {
+      while (auto chunk = write_queue.Pop()) {
+        WriteFull(out_fd, chunk->data.data(), chunk->data.size());
+        written += chunk->data.size();
+      }
+    } catch (...) {
+      writer_error = std::current_exception();
+      read_queue.Close();
+    }
+    write_queue.Close();
+  });
+
+  std::exception_ptr cipher_error;
+  try {
+    uint64_t block = 0;
+    uint8_t chain[kBlockSize];
+    std::copy(cipher.iv(), cipher.iv() + kBlockSize, chain);
+    bool seen_last = false;
+    while (auto chunk = read_queue.Pop()) {
+      std::vector<uint8_t>& in = chunk->data;
+      if (padded && chunk->last && !options.decrypt) {
+        uint8_t pad = kBlockSize - in.size() % kBlockSize;
+        in.resize(in.size() + pad, pad);
+      }
+      CheckCounterRange(block * kBlockSize + in.size(), options.mode);
+      if (padded && options.decrypt && in.size() % kBlockSize != 0) {
+        throw std::runtime_error(
+            "ciphertext is not aligned with 128-bit blocks");
+      }
+      Chunk out;
+      out.data.resize(in.size());
+      out.last = chunk->last;
+      ProcessRange(cipher, in.data(), out.data.data(), in.size(), block, chain,
+                   options);
+      if (in.size() >= kBlockSize) {
+        const uint8_t* next_chain =
+            options.decrypt ? in.data() + in.size() - kBlockSize
+                            : out.data.data() + out.data.size() - kBlockSize;
+        std::copy(next_chain, next_chain + kBlockSize, chain);
+      }
+      block += in.size() / kBlockSize;
+      if (padded && chunk->last && options.decrypt) {
+        out.data.resize(out.data.size() -
+                        PaddingLength(out.data.data(), out.data.size()));
+      }
+      seen_last = chunk->last;
+      if (!write_queue.Push(std::move(out))) break;
+    }
+    if (!seen_last && !reader_error && !writer_error) {
+      throw std::runtime_error("pipeline stopped early");
+    }
+  } catch (...) {
+    cipher_error = std::current_exception();
+    read_queue.Close();
+  }
+  write_queue.Close();
+  reader.join();
+  writer.join();
+  for (const auto& error : {reader_error, cipher_error, writer_error}) {
+    if (error) std::rethrow_exception(error);
+  }
+  return written;
+}
+
+uint64_t CipherFile(const std::string& input_path,
+                    const std::string& output_path,
+                    const FileCipherOptions& raw_options) {
+  const FileCipherOptions options = Normalize(raw_options);
+  if (input_path == "-" || output_path == "-") {
+    std::optional<ScopedFd> in, out;
+    if (input_path != "-") {
+      in.emplace(open(input_path.c_str(), O_RDONLY));
+      if (in->get() < 0) ThrowErrno("open " + input_path);
+    }
+    if (output_path != "-") {
+      out.emplace(
+          OpenOutput(output_path, in ? in->get() : STDIN_FILENO, O_WRONLY));
+    }
+    return CipherStream(in ? in->get() : STDIN_FILENO,
+                        out ? out->get() : STDOUT_FILENO, options);
+  }
+
+  const BlockCipher cipher(options);
+  const bool padded = IsPadded(options.mode);
+  ScopedFd in_fd(open(input_path.c_str(), O_RDONLY));
+  if (in_fd.get() < 0) ThrowErrno("open " + input_path);
+  ScopedFd out_fd(OpenOutput(output_path, in_fd.get(), O_RDWR));
+
+  struct stat st;
+  if (fstat(in_fd.get(), &st) != 0) ThrowErrno("stat " + input_path);
+  if (!S_ISREG(st.st_mode)) {
+    return CipherStream(in_fd.get(), out_fd.get(), options);
+  }
+  size_t in_size = st.st_size;
+  CheckCounterRange(in_size, options.mode);
+  if (padded && options.decrypt &&
+      (in_size == 0 || in_size % kBlockSize != 0)) {
+    throw std::runtime_error("ciphertext is not aligned with 128-bit blocks");
+  }
+  // Only full blocks are read from the input mapping, the final padded block
+  // is assembled separately.
+  size_t body_size =
+      padded && !options.decrypt ? in_size / kBlockSize * kBlockSize : in_size;
+  size_t out_size =
+      padded && !options.decrypt ? body_size + kBlockSize : in_size;
+  if (out_size == 0) {
+    return 0;
+  }
+  if (ftruncate(out_fd.get(), out_size) != 0) {
+    ThrowErrno("truncate " + output_path);
+  }
+
+  std::optional<Mapping> in_map;
+  if (in_size > 0) in_map.emplace(in_fd.get(), in_size, /*writable=*/false);
+  Mapping out_map(out_fd.get(), out_size, /*writable=*/true);
+  if ((in_map && in_map->data() == nullptr) || out_map.data() == nullptr) {
+    // e.g. file systems without mmap support
+    if (ftruncate(out_fd.get(), 0) != 0) ThrowErrno("truncate " + output_path);
+    return CipherStream(in_fd.get(), out_fd.get(), options);
+  }
+  const uint8_t* in = in_map ? in_map->data() : nullptr;
+  uint8_t* out = out_map.data();
+
+  ProcessRange(cipher, in, out, body_size, 0, cipher.iv(), options);
+  size_t final_size = out_size;
+  if (padded && !options.decrypt) {
+    uint8_t last[kBlockSize];
+    size_t tail = in_size - body_size;
+    uint8_t pad = kBlockSize - tail;
+    std::copy(in + body_size, in + in_size, last);
+    std::fill(last + tail, last + kBlockSize, pad);
+    cipher.Process(last, out + body_size, kBlockSize, body_size / kBlockSize,
+                   body_size == 0 ? cipher.iv() : out + body_size - kBlockSize);
+  } else if (padded && options.decrypt) {
+    final_size -= PaddingLength(out, out_size);
+  }
+  if (final_size != out_size && ftruncate(out_fd.get(), final_size) != 0) {
+    ThrowErrno("truncate " + output_path);
+  }
+  return final_size;
+}
+
+void CipherBuffer(const uint8_t* in, uint8_t* out, size_t size,
+                  const FileCipherOptions& raw_options) {
+  const FileCipherOptions options = Normalize(raw_options);
+  const BlockCipher cipher(options);
+  if (IsPadded(options.mode) && size % kBlockSize != 0) {
+    throw std::invalid_argument("size is not aligned with 128-bit blocks");
+  }
+  CheckCounterRange(size, options.mode);
+  ProcessRange(cipher, in, out, size, 0, cipher.iv(), options);
+}
+
+}  // namespace cryptopals
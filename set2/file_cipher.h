@@ -0,0 +1,48 @@
+#ifndef CRYPTOPALS_SET2_FILE_CIPHER_H_
+#define CRYPTOPALS_SET2_FILE_CIPHER_H_
+
+#include <cstdint>
+#include <string>
+
+namespace cryptopals {
+
+enum class FileCipherMode { ECB, CBC, CTR };
+
+struct FileCipherOptions {
+  FileCipherMode mode = FileCipherMode::CTR;
+  bool decrypt = false;
+  std::string key;  // 128/192/256 bits
+  // CBC: 128-bit iv. CTR: 32-bit nonce followed by 64-bit iv, the same layout
+  // as Aes::CtrEncrypt. Unused by ECB.
+  std::string iv;
+  unsigned threads = 0;             // 0 means all hardware threads
+  size_t chunk_size = 1024 * 1024;  // bytes per work unit, multiple of 16
+};
+
+// Encrypts or decrypts `input_path` into `output_path`. ECB/CBC add PKCS#7
+// padding on encryption and remove it on decryption, CTR has no padding.
+//
+// Regular files are memory-mapped on both sides and processed block-parallel
+// (CBC encryption is inherently sequential). Anything that cannot be mapped,
+// including "-" for stdin/stdout, goes through CipherStream instead.
+//
+// Returns the number of bytes written. Throws std::invalid_argument on bad
+// options or if the output is the input file (e.g. through a link), and
+// std::runtime_error on I/O errors or invalid padding.
+uint64_t CipherFile(const std::string& input_path,
+                    const std::string& output_path,
+                    const FileCipherOptions& options);
+
+// Bounded reader -> cipher -> writer pipeline between two file descriptors,
+// holding at most a few `chunk_size` buffers in memory at a time.
+uint64_t CipherStream(int in_fd, int out_fd, const FileCipherOptions& options);
+
+// Runs the cipher over an in-memory buffer without any padding, `size` needs
+// to be aligned with 128-bit blocks for ECB/CBC. `in` and `out` must not
+// overlap. Used for benchmarking.
+void CipherBuffer(const uint8_t* in, uint8_t* out, size_t size,
+                  const FileCipherOptions& options);
+
+}  // namespace cryptopals
+
+#endif  // CRYPTOPALS_SET2_FILE_CIPHER_H_
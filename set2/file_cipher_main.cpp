@@ -0,0 +1,148 @@
+// Command-line front end of file_cipher.h.
+//
+// Usage:
+//   file_cipher_cli encrypt|decrypt --mode=ctr|cbc|ecb --key=HEX [--iv=HEX]
+//       [--threads=N] [--chunk_kib=N] INPUT OUTPUT
+//   file_cipher_cli bench [--size_mib=N] [--threads=N] [--chunk_kib=N]
+//
+// INPUT/OUTPUT may be "-" for stdin/stdout. For CTR, --iv is the 32-bit nonce
+// followed by the 64-bit iv (24 hex digits).
+
+#include <openssl/rand.h>
+
+#include <chrono>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/strings/escaping.h"
+#include "absl/strings/numbers.h"
+#include "file_cipher.h"
+
+namespace cryptopals {
+namespace {
+
+int Usage() {
+  std::cerr << "Usage:\n"
+               "  file_cipher_cli encrypt|decrypt --mode=ctr|cbc|ecb "
+               "--key=HEX [--iv=HEX] [--threads=N] [--chunk_kib=N] INPUT "
+               "OUTPUT\n"
+               "  file_cipher_cli bench [--size_mib=N] [--threads=N] "
+               "[--chunk_kib=N]\n";
+  return 2;
+}
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+void PrintThroughput(const std::string& label, uint64_t bytes,
+                     double seconds) {
+  std::cerr << std::left << std::setw(12) << label << std::right
+            << std::setw(8) << std::fixed << std::setprecision(3)
+            << bytes / seconds / 1e9 << " GB/s (" << bytes << " bytes in "
+            << seconds << " s)" << std::endl;
+}
+
+int Bench(size_t size_mib, FileCipherOptions options) {
+  size_t size = size_mib * 1024 * 1024;
+  std::vector<uint8_t> in(size), out(size);
+  RAND_bytes(in.data(), static_cast<int>(std::min<size_t>(size, 1 << 20)));
+  options.key = std::string(16, 'k');
+  for (auto [mode, name] : {std::pair{FileCipherMode::CTR, "ctr"},
+                            {FileCipherMode::CBC, "cbc"},
+                            {FileCipherMode::ECB, "ecb"}}) {
+    options.mode = mode;
+    options.iv = std::string(mode == FileCipherMode::CTR   ? 12
+                             : mode == FileCipherMode::CBC ? 16
+                                                           : 0,
+                             'i');
+    for (bool decrypt : {false, true}) {
+      options.decrypt = decrypt;
+      auto start = std::chrono::steady_clock::now();
+      CipherBuffer(in.data(), out.data(), size, options);
+      PrintThroughput(std::string(name) + (decrypt ? " decrypt" : " encrypt"),
+                      size, Seconds(start));
+    }
+  }
+  return 0;
+}
+
+int Main(int argc, char** argv) {
+  if (argc < 2) {
+    return Usage();
+  }
+  std::string command = argv[1];
+  FileCipherOptions options;
+  size_t size_mib = 1024;
+  std::vector<std::string> paths;
+  for (int i = 2; i < argc; i++) {
+    std::string arg = argv[i];
+    auto value = [&arg](const std::string& flag) -> const char* {
+      return arg.rfind(flag + "=", 0) == 0 ? arg.c_str() + flag.size() + 1
+                                           : nullptr;
+    };
+    if (const char* v = value("--mode")) {
+      std::string mode = v;
+      if (mode == "ctr") {
+        options.mode = FileCipherMode::CTR;
+      } else if (mode == "cbc") {
+        options.mode = FileCipherMode::CBC;
+      } else if (mode == "ecb") {
+        options.mode = FileCipherMode::ECB;
+      } else {
+        return Usage();
+      }
+    } else if (const char* v = value("--key")) {
+      options.key = absl::HexStringToBytes(v);
+    } else if (const char* v = value("--iv")) {
+      options.iv = absl::HexStringToBytes(v);
+    } else if (const char* v = value("--threads")) {
+      if (!absl::SimpleAtoi(v, &options.threads)) {
+        return Usage();
+      }
+    } else if (const char* v = value("--chunk_kib")) {
+      size_t chunk_kib = 0;
+      if (!absl::SimpleAtoi(v, &chunk_kib)) {
+        return Usage();
+      }
+      options.chunk_size = chunk_kib * 1024;
+    } else if (const char* v = value("--size_mib")) {
+      if (!absl::SimpleAtoi(v, &size_mib)) {
+        return Usage();
+      }
+    } else if (arg.rfind("--", 0) == 0) {
+      return Usage();
+    } else {
+      paths.push_back(arg);
+    }
+  }
+
+  if (command == "bench") {
+    return Bench(size_mib, options);
+  }
+  if ((command != "encrypt" && command != "decrypt") || paths.size() != 2) {
+    return Usage();
+  }
+  options.decrypt = command == "decrypt";
+  auto start = std::chrono::steady_clock::now();
+  uint64_t written = CipherFile(paths[0], paths[1], options);
+  PrintThroughput(command, written, Seconds(start));
+  return 0;
+}
+
+}  // namespace
+}  // namespace cryptopals
+
+int main(int argc, char** argv) {
+  try {
+    return cryptopals::Main(argc, argv);
+  } catch (const std::exception& e) {
+    std::cerr << "file_cipher_cli: " << e.what() << std::endl;
+    return 1;
+  }
+}
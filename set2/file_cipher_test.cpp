@@ -0,0 +1,144 @@
+#include "file_cipher.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "aes.h"
+#include "gtest/gtest.h"
+#include "padding.h"
+#include "rand_util.h"
+
+namespace cryptopals {
+namespace {
+
+std::string TempPath(const std::string& name) {
+  return ::testing::TempDir() + "file_cipher_test_" + name;
+}
+
+void WriteFile(const std::string& path, const std::string& content) {
+  std::ofstream file(path, std::ios::out | std::ios::binary);
+  file << content;
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream file(path, std::ios::in | std::ios::binary);
+  std::stringstream ss;
+  ss << file.rdbuf();
+  return ss.str();
+}
+
+// Expected ciphertext from the string based Aes helpers.
+std::string Reference(const std::string& plaintext,
+                      const FileCipherOptions& options) {
+  switch (options.mode) {
+    case FileCipherMode::ECB:
+      return Aes::EcbEncrypt(Padding::Pkcs7Encode(plaintext, 16), options.key);
+    case FileCipherMode::CBC:
+      return Aes::CbcEncrypt(Padding::Pkcs7Encode(plaintext, 16), options.key,
+                             options.iv);
+    case FileCipherMode::CTR:
+      return Aes::CtrEncrypt(plaintext, options.key, options.iv.substr(0, 4),
+                             options.iv.substr(4));
+  }
+  throw std::runtime_error("Unexpected FileCipherMode");
+}
+
+std::vector<FileCipherOptions> AllModes() {
+  std::vector<FileCipherOptions> all(3);
+  all[0].mode = FileCipherMode::ECB;
+  all[1].mode = FileCipherMode::CBC;
+  all[1].iv = util::RandStr(16);
+  all[2].mode = FileCipherMode::CTR;
+  all[2].iv = util::RandStr(12);
+  for (auto& options : all) {
+    options.key = util::RandStr(16);
+    options.threads = 4;
+    options.chunk_size = 64;  // force many work units
+  }
+  return all;
+}
+
+TEST(FileCipherTest, MappedFileCircling) {
+  std::string plain_path = TempPath("plain");
+  std::string cipher_path = TempPath("cipher");
+  std::string decrypted_path = TempPath("decrypted");
+  for (size_t size : {0, 1, 15, 16, 17, 1000, 4096}) {
+    std::string plaintext = util::RandStr(size);
+    WriteFile(plain_path, plaintext);
+    for (auto options : AllModes()) {
+      std::string expected = Reference(plaintext, options);
+      EXPECT_EQ(expected.size(),
+                CipherFile(plain_path, cipher_path, options));
+      EXPECT_EQ(expected, ReadFile(cipher_path));
+      options.decrypt = true;
+      EXPECT_EQ(size, CipherFile(cipher_path, decrypted_path, options));
+      EXPECT_EQ(plaintext, ReadFile(decrypted_path));
+    }
+  }
+}
+
+TEST(FileCipherTest, StreamCircling) {
+  std::string plain_path = TempPath("plain");
+  std::string cipher_path = TempPath("cipher");
+  std::string decrypted_path = TempPath("decrypted");
+  for (size_t size : {0, 15, 64, 65, 1000}) {
+    std::string plaintext = util::RandStr(size);
+    WriteFile(plain_path, plaintext);
+    for (auto options : AllModes()) {
+      int in = open(plain_path.c_str(), O_RDONLY);
+      int out = open(cipher_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      CipherStream(in, out, options);
+      close(in);
+      close(out);
+      EXPECT_EQ(Reference(plaintext, options), ReadFile(cipher_path));
+
+      options.decrypt = true;
+      in = open(cipher_path.c_str(), O_RDONLY);
+      out = open(decrypted_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      EXPECT_EQ(size, CipherStream(in, out, options));
+      close(in);
+      close(out);
+      EXPECT_EQ(plaintext, ReadFile(decrypted_path));
+    }
+  }
+}
+
+TEST(FileCipherTest, InvalidPadding) {
+  std::string cipher_path = TempPath("cipher");
+  std::string decrypted_path = TempPath("decrypted");
+  FileCipherOptions options;
+  options.mode = FileCipherMode::ECB;
+  options.decrypt = true;
+  options.key = "YELLOW SUBMARINE";
+  WriteFile(cipher_path, Aes::EcbEncrypt(std::string(16, 0), options.key));
+  EXPECT_THROW(CipherFile(cipher_path, decrypted_path, options),
+               std::runtime_error);
+  WriteFile(cipher_path, std::string(15, 0));
+  EXPECT_THROW(CipherFile(cipher_path, decrypted_path, options),
+               std::runtime_error);
+}
+
+TEST(FileCipherTest, RefusesToOverwriteInput) {
+  std::string plain_path = TempPath("plain");
+  std::string link_path = TempPath("link");
+  const std::string plaintext = util::RandStr(1000);
+  WriteFile(plain_path, plaintext);
+  unlink(link_path.c_str());
+  ASSERT_EQ(0, link(plain_path.c_str(), link_path.c_str()));
+
+  for (const auto& options : AllModes()) {
+    EXPECT_THROW(CipherFile(plain_path, plain_path, options),
+                 std::invalid_argument);
+    EXPECT_THROW(CipherFile(plain_path, link_path, options),
+                 std::invalid_argument);
+    EXPECT_EQ(plaintext, ReadFile(plain_path));
+  }
+  unlink(link_path.c_str());
+}
+
+}  // namespace
+}  // namespace cryptopals
@@ -0,0 +1,233 @@
+#include "instrumented_oracle.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <unordered_set>
+#include <utility>
+
+namespace cryptopals {
+
+namespace {
+
+constexpr size_t kSubBucketBits = 4;  // log2(LatencyHistogram::kSubBuckets)
+
+std::atomic<uint64_t> next_oracle_id{1};
+
+// Ids of the instances alive right now, so that threads can drop the cached
+// slots of destroyed instances.
+std::mutex live_ids_mu;
+std::unordered_set<uint64_t>& LiveIds() {
+  static auto* ids = new std::unordered_set<uint64_t>();
+  return *ids;
+}
+
+// Counters of a slot have a single writer, so a plain load and store is
+// enough; the atomics only make the concurrent reads in Stats() well
+// defined.
+void Add(std::atomic<uint64_t>* counter, uint64_t delta) {
+  counter->store(counter->load(std::memory_order_relaxed) + delta,
+                 std::memory_order_relaxed);
+}
+
+uint64_t Load(const std::atomic<uint64_t>& counter) {
+  return counter.load(std::memory_order_relaxed);
+}
+
+void AppendF(std::string* out, const char* format, double value) {
+  char buffer[64];
+  std::snprintf(buffer, sizeof(buffer), format, value);
+  out->append(buffer);
+}
+
+}  // namespace
+
+size_t LatencyHistogram::BucketOf(uint64_t value) {
+  if (value < kSubBuckets) {
+    return value;
+  }
+  size_t exponent = 63 - __builtin_clzll(value);
+  size_t sub = (value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+  return (exponent - kSubBucketBits + 1) * kSubBuckets + sub;
+}
+
+uint64_t LatencyHistogram::BucketLowerBound(size_t bucket) {
+  if (bucket < kSubBuckets) {
+    return bucket;
+  }
+  size_t shift = bucket / kSubBuckets - 1;
+  return (kSubBuckets + bucket % kSubBuckets) << shift;
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+  for (size_t b = 0; b < kBuckets; b++) {
+    counts_[b] += other.counts_[b];
+  }
+  count_ += other.count_;
+  max_ = std::max(max_, other.max_);
+}
+
+uint64_t LatencyHistogram::ValueAtQuantile(double q) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  auto rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) *
+                                              static_cast<double>(count_)));
+  rank = std::max<uint64_t>(rank, 1);
+  uint64_t seen = 0;
+  for (size_t b = 0; b < kBuckets; b++) {
+    seen += counts_[b];
+    if (seen >= rank) {
+      uint64_t upper = b + 1 < kBuckets
+                           ? BucketLowerBound(b + 1) - 1
+                           : std::numeric_limits<uint64_t>::max();
+      return std::min(upper, max_);
+    }
+  }
+  return max_;
+}
+
+std::string OracleStats::ToJson(size_t recovered_bytes) const {
+  std::string json = "{";
+  json += "\"queries\":" + std::to_string(queries);
+  json += ",\"errors\":" + std::to_string(errors);
+  json += ",\"bytes_sent\":" + std::to_string(bytes_sent);
+  json += ",\"bytes_received\":" + std::to_string(bytes_received);
+  AppendF(&json, ",\"seconds_in_oracle\":%.9g", SecondsInOracle());
+  if (recovered_bytes > 0) {
+    json += ",\"recovered_bytes\":" + std::to_string(recovered_bytes);
+    AppendF(&json, ",\"queries_per_recovered_byte\":%.6g",
+            static_cast<double>(queries) / recovered_bytes);
+    AppendF(&json, ",\"seconds_per_recovered_byte\":%.9g",
+            SecondsInOracle() / recovered_bytes);
+  }
+  json += ",\"latency_ns\":{\"count\":" + std::to_string(latency_ns.count());
+  AppendF(&json, ",\"mean\":%.6g",
+          latency_ns.count() ? static_cast<double>(nanos_in_oracle) /
+                                   latency_ns.count()
+                             : 0.0);
+  const std::pair<const char*, double> quantiles[] = {
+      {"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p999", 0.999}};
+  for (const auto& [name, q] : quantiles) {
+    json += ",\"" + std::string(name) +
+            "\":" + std::to_string(latency_ns.ValueAtQuantile(q));
+  }
+  json += ",\"max\":" + std::to_string(latency_ns.max());
+  json += ",\"buckets\":[";
+  bool first = true;
+  for (size_t b = 0; b < LatencyHistogram::kBuckets; b++) {
+    if (latency_ns.bucket_count(b) == 0) continue;
+    json += first ? "[" : ",[";
+    json += std::to_string(LatencyHistogram::BucketLowerBound(b)) + "," +
+            std::to_string(latency_ns.bucket_count(b)) + "]";
+    first = false;
+  }
+  json += "]}}";
+  return json;
+}
+
+struct InstrumentedOracle::Slot {
+  std::atomic<uint64_t> queries{0};
+  std::atomic<uint64_t> errors{0};
+  std::atomic<uint64_t> bytes_sent{0};
+  std::atomic<uint64_t> bytes_received{0};
+  std::atomic<uint64_t> nanos{0};
+  std::atomic<uint64_t> max_nanos{0};
+  std::array<std::atomic<uint64_t>, LatencyHistogram::kBuckets> latency{};
+};
+
+InstrumentedOracle::InstrumentedOracle(EncryptionOracle* oracle)
+    : oracle_(oracle), id_(next_oracle_id.fetch_add(1)) {
+  std::lock_guard<std::mutex> lock(live_ids_mu);
+  LiveIds().insert(id_);
+}
+
+InstrumentedOracle::~InstrumentedOracle() {
+  std::lock_guard<std::mutex> lock(live_ids_mu);
+  LiveIds().erase(id_);
+}
+
+std::vector<std::pair<uint64_t, InstrumentedOracle::Slot*>>&
+InstrumentedOracle::ThreadCache() {
+  thread_local std::vector<std::pair<uint64_t, Slot*>> cache;
+  return cache;
+}
+
+size_t InstrumentedOracle::ThreadCacheSize() { return ThreadCache().size(); }
+
+InstrumentedOracle::Slot* InstrumentedOracle::ThreadSlot() {
+  auto& cache = ThreadCache();
+  for (const auto& [id, slot] : cache) {
+    if (id == id_) return slot;
+  }
+  // First call from this thread. Entries of destroyed instances are dropped
+  // here, so the cache only holds instances that are still alive (ids are
+  // never reused, so stale entries are never matched in between).
+  {
+    std::lock_guard<std::mutex> lock(live_ids_mu);
+    const auto& live = LiveIds();
+    cache.erase(std::remove_if(cache.begin(), cache.end(),
+                               [&live](const std::pair<uint64_t, Slot*>& e) {
+                                 return live.count(e.first) == 0;
+                               }),
+                cache.end());
+  }
+  std::lock_guard<std::mutex> lock(mu_);
+  slots_.push_back(std::make_unique<Slot>());
+  cache.emplace_back(id_, slots_.back().get());
+  return slots_.back().get();
+}
+
+std::string InstrumentedOracle::Encrypt(std::string_view input) {
+  Slot* slot = ThreadSlot();
+  auto record = [slot, &input](std::chrono::steady_clock::time_point start,
+                               size_t received, bool error) {
+    auto nanos = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count());
+    Add(&slot->queries, 1);
+    Add(&slot->errors, error);
+    Add(&slot->bytes_sent, input.size());
+    Add(&slot->bytes_received, received);
+    Add(&slot->nanos, nanos);
+    if (nanos > Load(slot->max_nanos)) {
+      slot->max_nanos.store(nanos, std::memory_order_relaxed);
+    }
+    Add(&slot->latency[LatencyHistogram::BucketOf(nanos)], 1);
+  };
+  const auto start = std::chrono::steady_clock::now();
+  std::string output;
+  try {
+    output = oracle_->Encrypt(input);
+  } catch (...) {
+    record(start, 0, true);
+    throw;
+  }
+  record(start, output.size(), false);
+  return output;
+}
+
+OracleStats InstrumentedOracle::Stats() const {
+  OracleStats stats;
+  std::lock_guard<std::mutex> lock(mu_);
+  for (const auto& slot : slots_) {
+    stats.queries += Load(slot->queries);
+    stats.errors += Load(slot->errors);
+    stats.bytes_sent += Load(slot->bytes_sent);
+    stats.bytes_received += Load(slot->bytes_received);
+    stats.nanos_in_oracle += Load(slot->nanos);
+    for (size_t b = 0; b < LatencyHistogram::kBuckets; b++) {
+      if (uint64_t count = Load(slot->latency[b])) {
+        stats.latency_ns.AddToBucket(b, count);
+      }
+    }
+    stats.latency_ns.UpdateMax(Load(slot->max_nanos));
+  }
+  return stats;
+}
+
+}  // namespace cryptopals
@@ -0,0 +1,106 @@
+#ifndef CRYPTOPALS_SET2_INSTRUMENTED_ORACLE_H_
+#define CRYPTOPALS_SET2_INSTRUMENTED_ORACLE_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "encryption_oracle.h"
+
+namespace cryptopals {
+
+// Log-linear histogram in the style of HdrHistogram. Values below 16 have a
+// bucket each; above that every power of two is split into 16 buckets, so a
+// recorded value is known to within 1/16 of itself across the whole uint64_t
+// range with a fixed 976 buckets.
+class LatencyHistogram {
+ public:
+  static constexpr size_t kSubBuckets = 16;
+  static constexpr size_t kBuckets = (64 - 3) * kSubBuckets;
+
+  static size_t BucketOf(uint64_t value);
+  // Smallest value that lands in `bucket`.
+  static uint64_t BucketLowerBound(size_t bucket);
+
+  void Record(uint64_t value) {
+    AddToBucket(BucketOf(value), 1);
+    UpdateMax(value);
+  }
+  // For merging counts kept elsewhere; max() is updated separately.
+  void AddToBucket(size_t bucket, uint64_t count) {
+    counts_[bucket] += count;
+    count_ += count;
+  }
+  void UpdateMax(uint64_t value) { max_ = value > max_ ? value : max_; }
+  void Merge(const LatencyHistogram& other);
+
+  uint64_t count() const { return count_; }
+  uint64_t max() const { return max_; }
+  uint64_t bucket_count(size_t bucket) const { return counts_[bucket]; }
+  // Upper end of the bucket holding the value at quantile `q` in [0, 1],
+  // capped at max(). 0 if the histogram is empty.
+  uint64_t ValueAtQuantile(double q) const;
+
+ private:
+  std::array<uint64_t, kBuckets> counts_{};
+  uint64_t count_ = 0;
+  uint64_t max_ = 0;
+};
+
+struct OracleStats {
+  uint64_t queries = 0;
+  uint64_t errors = 0;  // queries that threw
+  uint64_t bytes_sent = 0;
+  uint64_t bytes_received = 0;
+  uint64_t nanos_in_oracle = 0;
+  LatencyHistogram latency_ns;
+
+  double SecondsInOracle() const { return nanos_in_oracle * 1e-9; }
+
+  // One JSON object with the counters and latency percentiles, followed by
+  // the non-empty histogram buckets as [lower bound, count] pairs. With
+  // `recovered_bytes` > 0, also queries and oracle time per recovered byte.
+  std::string ToJson(size_t recovered_bytes = 0) const;
+};
+
+// Decorator recording the traffic through an oracle: queries, bytes each
+// way, exceptions and a latency histogram. Every thread calling Encrypt gets
+// its own slot of counters which only it writes, so recording takes no lock
+// and no atomic read-modify-write; Stats() sums the slots. `oracle` must
+// outlive the decorator, and may be called concurrently if it allows that.
+class InstrumentedOracle : public EncryptionOracle {
+ public:
+  explicit InstrumentedOracle(EncryptionOracle* oracle);
+  ~InstrumentedOracle() override;
+
+  std::string Encrypt(std::string_view input) override;
+
+  // Consistent per counter, but a snapshot taken while other threads are
+  // querying may miss their in-flight calls.
+  OracleStats Stats() const;
+
+  // Number of instances whose slots the calling thread has cached; only
+  // instances still alive at the thread's last first call are kept.
+  static size_t ThreadCacheSize();
+
+ private:
+  struct Slot;
+
+  static std::vector<std::pair<uint64_t, Slot*>>& ThreadCache();
+  Slot* ThreadSlot();
+
+  EncryptionOracle* const oracle_;
+  const uint64_t id_;  // unique per instance, keys the per-thread slot cache
+  mutable std::mutex mu_;
+  std::vector<std::unique_ptr<Slot>> slots_;
+};
+
+}  // namespace cryptopals
+
+#endif  // CRYPTOPALS_SET2_INSTRUMENTED_ORACLE_H_
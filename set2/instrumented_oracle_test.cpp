@@ -0,0 +1,116 @@
+#include "instrumented_oracle.h"
+
+#include <stdexcept>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace cryptopals {
+namespace {
+
+// Returns the input doubled; throws on "throw".
+class EchoOracle : public EncryptionOracle {
+ public:
+  std::string Encrypt(std::string_view input) override {
+    if (input == "throw") throw std::runtime_error("oracle failure");
+    return std::string(input) + std::string(input);
+  }
+};
+
+TEST(LatencyHistogramTest, Buckets) {
+  for (uint64_t value : {0ull, 1ull, 15ull, 16ull, 17ull, 31ull, 32ull, 33ull,
+                         1000ull, 123456789ull, ~0ull}) {
+    size_t bucket = LatencyHistogram::BucketOf(value);
+    ASSERT_LT(bucket, LatencyHistogram::kBuckets);
+    uint64_t lower = LatencyHistogram::BucketLowerBound(bucket);
+    EXPECT_LE(lower, value);
+    // Within 1/16 of the value
+    EXPECT_LE(value - lower, value / LatencyHistogram::kSubBuckets);
+    if (bucket + 1 < LatencyHistogram::kBuckets) {
+      EXPECT_GT(LatencyHistogram::BucketLowerBound(bucket + 1), value);
+    }
+  }
+  EXPECT_EQ(LatencyHistogram::kBuckets - 1, LatencyHistogram::BucketOf(~0ull));
+}
+
+TEST(LatencyHistogramTest, Quantiles) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0, histogram.ValueAtQuantile(0.5));
+  for (uint64_t v = 1; v <= 1000; v++) histogram.Record(v);
+  EXPECT_EQ(1000, histogram.count());
+  EXPECT_EQ(1000, histogram.max());
+  EXPECT_EQ(1, histogram.ValueAtQuantile(0));
+  EXPECT_NEAR(500, histogram.ValueAtQuantile(0.5), 500 / 16);
+  EXPECT_NEAR(990, histogram.ValueAtQuantile(0.99), 990 / 16);
+  EXPECT_EQ(1000, histogram.ValueAtQuantile(1));
+
+  LatencyHistogram other;
+  other.Record(5000);
+  histogram.Merge(other);
+  EXPECT_EQ(1001, histogram.count());
+  EXPECT_EQ(5000, histogram.ValueAtQuantile(1));
+}
+
+TEST(InstrumentedOracleTest, CountsTrafficAcrossThreads) {
+  EchoOracle echo;
+  InstrumentedOracle oracle(&echo);
+  constexpr int kThreads = 4;
+  constexpr int kQueries = 1000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&oracle]() {
+      for (int i = 0; i < kQueries; i++) {
+        EXPECT_EQ("abcabc", oracle.Encrypt("abc"));
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  EXPECT_THROW(oracle.Encrypt("throw"), std::runtime_error);
+
+  OracleStats stats = oracle.Stats();
+  EXPECT_EQ(kThreads * kQueries + 1, stats.queries);
+  EXPECT_EQ(1, stats.errors);
+  EXPECT_EQ(kThreads * kQueries * 3 + 5, stats.bytes_sent);
+  EXPECT_EQ(kThreads * kQueries * 6, stats.bytes_received);
+  EXPECT_EQ(stats.queries, stats.latency_ns.count());
+  EXPECT_GT(stats.nanos_in_oracle, 0);
+  EXPECT_GE(stats.nanos_in_oracle, stats.latency_ns.max());
+
+  std::string json = stats.ToJson(/*recovered_bytes=*/10);
+  EXPECT_NE(std::string::npos, json.find("\"queries\":4001,"));
+  EXPECT_NE(std::string::npos,
+            json.find("\"queries_per_recovered_byte\":400.1,"));
+  EXPECT_NE(std::string::npos, json.find("\"p99\":"));
+  EXPECT_EQ('}', json.back());
+  EXPECT_EQ(std::string::npos, stats.ToJson().find("recovered"));
+}
+
+TEST(InstrumentedOracleTest, InstancesAreIndependent) {
+  EchoOracle echo;
+  auto first = std::make_unique<InstrumentedOracle>(&echo);
+  first->Encrypt("a");
+  first.reset();
+  // A new instance may get the same address, but not the old counters.
+  InstrumentedOracle second(&echo);
+  second.Encrypt("b");
+  EXPECT_EQ(1, second.Stats().queries);
+}
+
+TEST(InstrumentedOracleTest, ThreadCacheDropsDestroyedInstances) {
+  EchoOracle echo;
+  std::thread([&echo]() {
+    InstrumentedOracle kept(&echo);
+    kept.Encrypt("a");
+    for (int i = 0; i < 1000; i++) {
+      InstrumentedOracle oracle(&echo);
+      oracle.Encrypt("a");
+    }
+    // `kept` and the last of the loop.
+    EXPECT_LE(InstrumentedOracle::ThreadCacheSize(), 2);
+    kept.Encrypt("b");
+    EXPECT_EQ(2, kept.Stats().queries);
+  }).join();
+}
+
+}  // namespace
+}  // namespace cryptopals
@@ -1,32 +1,34 @@
-#include <functional>
-#include <random>
+#include "mode_detection.h"
+
 #include <stdexcept>
 
-#include "absl/container/flat_hash_set.h"
+#include "../set1/aes_in_ecb_mode.h"
 #include "aes.h"
-#include "gtest/gtest.h"
 #include "padding.h"
 #include "rand_util.h"
 
 namespace cryptopals {
-namespace {
 
-enum class CipherMode { ECB, CBC };
+namespace {
 
+// Leaves room for the PKCS#7 padding so that Padding::Pkcs7Pad won't need to
+// reallocate.
 std::string RandPadding(std::string_view input, uint8_t prefix_len,
                         uint8_t suffix_len) {
-  return util::RandStr(prefix_len) + std::string(input) +
-         util::RandStr(suffix_len);
+  std::string output;
+  output.reserve(prefix_len + input.size() + suffix_len + 16);
+  output.append(util::RandStr(prefix_len))
+      .append(input)
+      .append(util::RandStr(suffix_len));
+  return output;
 }
 
-std::string EncryptionOracleWithMode(std::string_view input, CipherMode mode) {
-  std::default_random_engine generator(std::random_device{}());
-  auto random_length = [&generator]() {
-    return std::uniform_int_distribution<uint8_t>(5, 10)(generator);
-  };
+}  // namespace
 
-  auto extended = RandPadding(input, random_length(), random_length());
-  auto padded = Padding::Pkcs7Encode(extended, 16);
+std::string EncryptionOracleWithMode(std::string_view input, CipherMode mode) {
+  auto padded =
+      RandPadding(input, util::RandUniform(5, 10), util::RandUniform(5, 10));
+  Padding::Pkcs7Pad(&padded, 16);
   auto key = util::RandStr(16);
 
   switch (mode) {
@@ -40,11 +42,7 @@ std::string EncryptionOracleWithMode(std::string_view input, CipherMode mode) {
 }
 
 std::string EncryptionOracle(std::string_view input) {
-  std::default_random_engine generator(std::random_device{}());
-  auto random_mode = [&generator]() {
-    return std::uniform_int_distribution<uint8_t>(0, 1)(generator);
-  };
-  bool mode = random_mode();  // 0 - ECB, 1 - CBC
+  bool mode = util::RandUniform(0, 1);  // 0 - ECB, 1 - CBC
   if (!mode) {
     return EncryptionOracleWithMode(input, CipherMode::ECB);
   } else {
@@ -53,52 +51,8 @@ std::string EncryptionOracle(std::string_view input) {
 }
 
 CipherMode DetectMode(std::string_view ciphertext) {
-  absl::flat_hash_set<std::string_view> encountered;
-  for (int i = 0; i < ciphertext.size(); i += 16) {
-    auto block = ciphertext.substr(i, 16);
-    if (encountered.contains(block)) {
-      return CipherMode::ECB;
-    }
-    encountered.insert(block);
-  }
-  return CipherMode::CBC;
+  return CountRepeatedBlocks(ciphertext) > 0 ? CipherMode::ECB
+                                             : CipherMode::CBC;
 }
 
-TEST(ModeDetection, DetectECB) {
-  std::string input(43, 'a');  // 11 (worst prefix) + 32 (two blocks)
-  for (int i = 0; i < 100; i++) {
-    std::string ciphertext = EncryptionOracleWithMode(input, CipherMode::ECB);
-    EXPECT_EQ(CipherMode::ECB, DetectMode(ciphertext));
-  }
-}
-
-// If the random prefix is all 'a', this test will fail
-TEST(ModeDetection, DetectCBC) {
-  std::string input(43, 'a');  // 11 (worst prefix) + 32 (two blocks)
-  for (int i = 0; i < 100; i++) {
-    std::string ciphertext = EncryptionOracleWithMode(input, CipherMode::CBC);
-    EXPECT_EQ(CipherMode::CBC, DetectMode(ciphertext));
-  }
-}
-
-// This is not guaranteed to pass every time, you'll be very lucky if it
-// fails :P
-// The process complies Binomial distribution with standard deviation:
-// \sigma = sqrt(250) = 15.81
-// I'm using normal approximation and I set confidence interval at mean +-
-// 3\sigma, i.e. [453, 547]. The chance of failure is about 0.269% (1/370).
-TEST(ModeDetection, FreqAnalysis) {
-  std::string input(43, 'a');  // 11 (worst prefix) + 32 (two blocks)
-  int ecb_count = 0;
-  for (int i = 0; i < 1000; i++) {
-    std::string ciphertext = EncryptionOracle(input);
-    if (DetectMode(ciphertext) == CipherMode::ECB) {
-      ecb_count++;
-    }
-  }
-  EXPECT_GT(ecb_count, 453);
-  EXPECT_LT(ecb_count, 547);
-}
-
-}  // namespace
-}  // namespace cryptopals
\ No newline at end of file
+}  // namespace cryptopals
@@ -0,0 +1,22 @@
+#ifndef CRYPTOPALS_SET2_MODE_DETECTION_H_
+#define CRYPTOPALS_SET2_MODE_DETECTION_H_
+
+#include <string>
+#include <string_view>
+
+namespace cryptopals {
+
+enum class CipherMode { ECB, CBC };
+
+// The challenge 11 oracle: 5-10 random bytes before and after `input`,
+// PKCS#7 padding, then AES-128 in `mode` under a fresh random key (and IV).
+std::string EncryptionOracleWithMode(std::string_view input, CipherMode mode);
+// Same with ECB or CBC chosen at random.
+std::string EncryptionOracle(std::string_view input);
+
+// ECB if any block of `ciphertext` repeats, CBC otherwise.
+CipherMode DetectMode(std::string_view ciphertext);
+
+}  // namespace cryptopals
+
+#endif  // CRYPTOPALS_SET2_MODE_DETECTION_H_
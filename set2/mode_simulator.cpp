@@ -0,0 +1,203 @@
+#include "mode_simulator.h"
+
+#include <openssl/evp.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "../util/parallel.h"
+
+namespace cryptopals {
+
+namespace {
+
+constexpr size_t kBlockSize = 16;
+constexpr size_t kMaxPadding = 10;  // of the random prefix and suffix each
+constexpr size_t kSamplesPerTask = 4096;
+
+// Not cryptographic, only fast and well distributed.
+class SplitMix64 {
+ public:
+  explicit SplitMix64(uint64_t seed) : state_(seed) {}
+
+  uint64_t Next() {
+    uint64_t z = (state_ += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30u)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27u)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31u);
+  }
+
+  void Fill(uint8_t* out, size_t size) {
+    for (size_t i = 0; i < size; i += 8) {
+      uint64_t r = Next();
+      std::memcpy(out + i, &r, std::min<size_t>(8, size - i));
+    }
+  }
+
+ private:
+  uint64_t state_;
+};
+
+// Independent stream for every sample. Starting from a mixed state keeps the
+// streams of consecutive samples from overlapping.
+SplitMix64 SampleRng(uint64_t seed, uint64_t sample) {
+  SplitMix64 mix(seed ^ (sample * 0xd6e8feb86659fd93ull));
+  return SplitMix64(mix.Next());
+}
+
+// ECB and CBC contexts of every key, reused by all samples of a task. Not
+// shared between threads, since EVP contexts carry state.
+class KeyContexts {
+ public:
+  explicit KeyContexts(std::string_view keys) {
+    for (size_t i = 0; i < keys.size(); i += kBlockSize) {
+      const auto* key = reinterpret_cast<const uint8_t*>(keys.data() + i);
+      ecb_.push_back(NewContext(EVP_aes_128_ecb(), key));
+      cbc_.push_back(NewContext(EVP_aes_128_cbc(), key));
+    }
+  }
+  ~KeyContexts() {
+    for (auto* ctx : ecb_) EVP_CIPHER_CTX_free(ctx);
+    for (auto* ctx : cbc_) EVP_CIPHER_CTX_free(ctx);
+  }
+  KeyContexts(const KeyContexts&) = delete;
+  KeyContexts& operator=(const KeyContexts&) = delete;
+
+  // Encrypts the `size` (block aligned) bytes of `data` in place.
+  void Encrypt(CipherMode mode, size_t key, const uint8_t* iv, uint8_t* data,
+               size_t size) {
+    EVP_CIPHER_CTX* ctx = mode == CipherMode::ECB ? ecb_[key] : cbc_[key];
+    int out_size = 0;
+    if ((mode == CipherMode::CBC &&
+         EVP_EncryptInit_ex(ctx, nullptr, nullptr, nullptr, iv) != 1) ||
+        EVP_EncryptUpdate(ctx, data, &out_size, data,
+                          static_cast<int>(size)) != 1 ||
+        static_cast<size_t>(out_size) != size) {
+      // Otherwise plaintext would be left in the arena as ciphertext.
+      throw std::runtime_error("AES encryption failed");
+    }
+  }
+
+ private:
+  static EVP_CIPHER_CTX* NewContext(const EVP_CIPHER* cipher,
+                                    const uint8_t* key) {
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    if (ctx == nullptr ||
+        EVP_EncryptInit_ex(ctx, cipher, nullptr, key, nullptr) != 1) {
+      EVP_CIPHER_CTX_free(ctx);
+      throw std::runtime_error("failed to set up AES context");
+    }
+    EVP_CIPHER_CTX_set_padding(ctx, 0);
+    return ctx;
+  }
+
+  std::vector<EVP_CIPHER_CTX*> ecb_;
+  std::vector<EVP_CIPHER_CTX*> cbc_;
+};
+
+}  // namespace
+
+uint64_t ModeDetectionStats::samples() const {
+  return counts[0][0] + counts[0][1] + counts[1][0] + counts[1][1];
+}
+
+double ModeDetectionStats::Accuracy() const {
+  uint64_t total = samples();
+  return total ? static_cast<double>(counts[0][0] + counts[1][1]) / total : 0;
+}
+
+double ModeDetectionStats::Recall(CipherMode mode) const {
+  auto m = static_cast<size_t>(mode);
+  uint64_t total = counts[m][0] + counts[m][1];
+  return total ? static_cast<double>(counts[m][m]) / total : 0;
+}
+
+double ModeDetectionStats::DetectedRate(CipherMode mode) const {
+  auto m = static_cast<size_t>(mode);
+  uint64_t total = samples();
+  return total ? static_cast<double>(counts[0][m] + counts[1][m]) / total : 0;
+}
+
+ModeOracleSimulator::ModeOracleSimulator(uint64_t seed)
+    : seed_(seed), keys_(kKeys * kBlockSize, 0) {
+  SplitMix64(seed).Fill(reinterpret_cast<uint8_t*>(&keys_[0]), keys_.size());
+}
+
+void ModeOracleSimulator::Generate(std::string_view input, size_t count,
+                                   ModeSamples* samples, unsigned threads) {
+  // Largest sample: both paddings at their maximum plus a full padding block.
+  const size_t stride =
+      (input.size() + 2 * kMaxPadding) / kBlockSize * kBlockSize + kBlockSize;
+  samples->stride = stride;
+  samples->arena.resize(count * stride);
+  samples->sizes.resize(count);
+  samples->modes.resize(count);
+  auto* arena = reinterpret_cast<uint8_t*>(&samples->arena[0]);
+  const uint64_t first = next_sample_;
+  next_sample_ += count;
+
+  util::ParallelFor(
+      count, kSamplesPerTask,
+      [&](size_t begin, size_t end) {
+        KeyContexts contexts(keys_);
+        for (size_t i = begin; i < end; i++) {
+          SplitMix64 rng = SampleRng(seed_, first + i);
+          uint64_t r = rng.Next();
+          const auto mode = static_cast<CipherMode>(r & 1u);
+          const size_t prefix = 5 + (r >> 8u) % 6;
+          const size_t suffix = 5 + (r >> 16u) % 6;
+          const size_t key = (r >> 24u) % kKeys;
+
+          uint8_t* out = arena + i * stride;
+          rng.Fill(out, prefix);
+          std::memcpy(out + prefix, input.data(), input.size());
+          rng.Fill(out + prefix + input.size(), suffix);
+          const size_t unpadded = prefix + input.size() + suffix;
+          const size_t size = unpadded / kBlockSize * kBlockSize + kBlockSize;
+          std::memset(out + unpadded, static_cast<int>(size - unpadded),
+                      size - unpadded);
+
+          uint8_t iv[kBlockSize];
+          if (mode == CipherMode::CBC) {
+            rng.Fill(iv, kBlockSize);
+          }
+          contexts.Encrypt(mode, key, iv, out, size);
+          samples->sizes[i] = static_cast<uint32_t>(size);
+          samples->modes[i] = mode;
+        }
+      },
+      threads);
+}
+
+ModeDetectionStats ClassifyModeSamples(
+    const ModeSamples& samples,
+    const std::function<CipherMode(std::string_view)>& detector,
+    unsigned threads) {
+  const size_t count = samples.size();
+  const size_t tasks = (count + kSamplesPerTask - 1) / kSamplesPerTask;
+  std::vector<ModeDetectionStats> partial(tasks);
+  util::ParallelFor(
+      count, kSamplesPerTask,
+      [&](size_t begin, size_t end) {
+        ModeDetectionStats& stats = partial[begin / kSamplesPerTask];
+        for (size_t i = begin; i < end; i++) {
+          auto actual = static_cast<size_t>(samples.modes[i]);
+          auto detected = static_cast<size_t>(detector(samples.ciphertext(i)));
+          stats.counts[actual][detected]++;
+        }
+      },
+      threads);
+
+  ModeDetectionStats total;
+  for (const auto& stats : partial) {
+    for (size_t a = 0; a < 2; a++) {
+      for (size_t d = 0; d < 2; d++) {
+        total.counts[a][d] += stats.counts[a][d];
+      }
+    }
+  }
+  return total;
+}
+
+}  // namespace cryptopals
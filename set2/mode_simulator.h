@@ -0,0 +1,77 @@
+#ifndef CRYPTOPALS_SET2_MODE_SIMULATOR_H_
+#define CRYPTOPALS_SET2_MODE_SIMULATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mode_detection.h"
+
+namespace cryptopals {
+
+// Labelled ciphertexts of the challenge 11 oracle. Sample i lives at the
+// start of slot i of `arena`, slots are `stride` bytes apart.
+struct ModeSamples {
+  std::string arena;
+  size_t stride = 0;
+  std::vector<uint32_t> sizes;
+  std::vector<CipherMode> modes;
+
+  size_t size() const { return modes.size(); }
+  std::string_view ciphertext(size_t i) const {
+    return std::string_view(arena.data() + i * stride, sizes[i]);
+  }
+};
+
+// Confusion matrix of a mode detector.
+struct ModeDetectionStats {
+  // counts[actual][detected], indexed by CipherMode.
+  uint64_t counts[2][2] = {};
+
+  uint64_t samples() const;
+  double Accuracy() const;
+  // Fraction of the `mode` samples that were detected as `mode`.
+  double Recall(CipherMode mode) const;
+  // Fraction of all samples that were detected as `mode`.
+  double DetectedRate(CipherMode mode) const;
+};
+
+// Generates samples of EncryptionOracle in bulk for statistical tests of the
+// detectors. Every sample draws its mode, prefix, suffix and IV like the
+// oracle does, but from a SplitMix64 stream seeded by (seed, sample number)
+// instead of the OS, and encrypts in place into a reused arena. Each sample
+// picks one of kKeys random keys, since a detector cannot tell one random key
+// from another anyway; this way the AES contexts of every key are set up once
+// per few thousand samples instead of once per sample.
+//
+// The output depends only on the seed and on the samples generated before,
+// not on the number of threads.
+class ModeOracleSimulator {
+ public:
+  static constexpr size_t kKeys = 64;
+
+  explicit ModeOracleSimulator(uint64_t seed);
+
+  // Replaces `samples` with the next `count` samples for `input`, on
+  // `threads` workers (0 means all cores). Buffers of `samples` are reused.
+  void Generate(std::string_view input, size_t count, ModeSamples* samples,
+                unsigned threads = 0);
+
+ private:
+  const uint64_t seed_;
+  std::string keys_;  // kKeys AES-128 keys
+  uint64_t next_sample_ = 0;
+};
+
+// Runs `detector` over all samples on `threads` workers (0 means all cores).
+ModeDetectionStats ClassifyModeSamples(
+    const ModeSamples& samples,
+    const std::function<CipherMode(std::string_view)>& detector = DetectMode,
+    unsigned threads = 0);
+
+}  // namespace cryptopals
+
+#endif  // CRYPTOPALS_SET2_MODE_SIMULATOR_H_
@@ -0,0 +1,113 @@
+#include "mode_simulator.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "gtest/gtest.h"
+
+namespace cryptopals {
+namespace {
+
+// Enough for tight statistical bands; the multi-million run that measures
+// throughput is DISABLED_Throughput below.
+constexpr size_t kSamples = 1 << 18;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// Generates and classifies `count` samples for `input`, printing throughput.
+ModeDetectionStats Simulate(std::string_view input, uint64_t seed,
+                            size_t count = kSamples) {
+  ModeOracleSimulator simulator(seed);
+  ModeSamples samples;
+  auto start = std::chrono::steady_clock::now();
+  simulator.Generate(input, count, &samples);
+  double generate = Seconds(start);
+  start = std::chrono::steady_clock::now();
+  ModeDetectionStats stats = ClassifyModeSamples(samples);
+  double classify = Seconds(start);
+  std::cout << count << " samples of " << input.size()
+            << " bytes: generated at " << count / generate / 1e6
+            << "M/s, classified at " << count / classify / 1e6
+            << "M/s, accuracy " << stats.Accuracy() << std::endl;
+  return stats;
+}
+
+TEST(ModeOracleSimulatorTest, SamplesLookLikeTheOracle) {
+  std::string input(43, 'a');
+  ModeOracleSimulator simulator(1);
+  ModeSamples samples;
+  simulator.Generate(input, 1000, &samples);
+  ASSERT_EQ(1000, samples.size());
+  for (size_t i = 0; i < samples.size(); i++) {
+    // 43 bytes plus 10 to 20 bytes of random padding fit in 4 blocks.
+    EXPECT_EQ(64, samples.ciphertext(i).size());
+    EXPECT_EQ(EncryptionOracle(input).size(), samples.ciphertext(i).size());
+  }
+
+  // Empty input: 10 to 20 bytes, padded to 16 or 32.
+  simulator.Generate("", 1000, &samples);
+  size_t sizes[3] = {};
+  for (size_t i = 0; i < samples.size(); i++) {
+    ASSERT_EQ(0, samples.sizes[i] % 16);
+    ASSERT_LE(samples.sizes[i], samples.stride);
+    sizes[samples.sizes[i] / 16]++;
+  }
+  EXPECT_GT(sizes[1], 0);
+  EXPECT_GT(sizes[2], 0);
+}
+
+TEST(ModeOracleSimulatorTest, Reproducible) {
+  std::string input(43, 'a');
+  ModeSamples one, four, other;
+  ModeOracleSimulator(7).Generate(input, 10000, &one, 1);
+  ModeOracleSimulator(7).Generate(input, 10000, &four, 4);
+  EXPECT_EQ(one.arena, four.arena);
+  EXPECT_EQ(one.modes, four.modes);
+
+  ModeOracleSimulator simulator(7);
+  simulator.Generate(input, 5000, &other);
+  simulator.Generate(input, 5000, &other);  // continues the stream
+  EXPECT_EQ(one.arena.substr(5000 * one.stride), other.arena);
+
+  ModeOracleSimulator(8).Generate(input, 10000, &other);
+  EXPECT_NE(one.arena, other.arena);
+}
+
+// FreqAnalysis in mode_detection_test with 262144 samples: the mode is
+// a fair coin and DetectMode is always right, since 43 bytes of 'a' span two
+// full blocks whatever the prefix.
+TEST(ModeOracleSimulatorTest, LargeSampleFreqAnalysis) {
+  ModeDetectionStats stats = Simulate(std::string(43, 'a'), 1);
+  EXPECT_EQ(kSamples, stats.samples());
+  EXPECT_EQ(1, stats.Accuracy());
+  // sigma = 0.5 / sqrt(n) = 0.001; the seed is fixed, so a 5 sigma band
+  // can only fail on a real bias.
+  const double band = 5 * 0.5 / std::sqrt(kSamples);
+  EXPECT_NEAR(0.5, stats.DetectedRate(CipherMode::ECB), band);
+}
+
+// With 38 bytes of 'a' there are two full blocks of 'a' only if the prefix is
+// 10 bytes long, so ECB is detected in 1/6 of the cases, and CBC always.
+TEST(ModeOracleSimulatorTest, ShortInputRecall) {
+  ModeDetectionStats stats = Simulate(std::string(38, 'a'), 2);
+  const double p = 1.0 / 6;
+  const double ecb_samples = stats.counts[0][0] + stats.counts[0][1];
+  EXPECT_NEAR(p, stats.Recall(CipherMode::ECB),
+              5 * std::sqrt(p * (1 - p) / ecb_samples));
+  EXPECT_EQ(1, stats.Recall(CipherMode::CBC));
+}
+
+// Four million samples, which allocates a 256 MiB arena; run with
+// --gtest_also_run_disabled_tests to measure throughput.
+TEST(ModeOracleSimulatorTest, DISABLED_Throughput) {
+  ModeDetectionStats stats = Simulate(std::string(43, 'a'), 1, 1 << 22);
+  EXPECT_EQ(1, stats.Accuracy());
+}
+
+}  // namespace
+}  // namespace cryptopals
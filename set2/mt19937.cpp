@@ -0,0 +1,223 @@
+#include "mt19937.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <stdexcept>
+
+#include "../util/parallel.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace cryptopals::util {
+
+namespace {
+
+// https://en.wikipedia.org/wiki/Mersenne_Twister#Algorithmic_detail
+constexpr size_t kN = Mt19937::kStateSize;
+constexpr size_t kM = 397;
+constexpr uint32_t kMatrixA = 0x9908b0df;
+constexpr uint32_t kUpperMask = 0x80000000;
+constexpr uint32_t kLowerMask = 0x7fffffff;
+constexpr uint32_t kInitMultiplier = 1812433253;
+
+inline uint32_t TwistWord(uint32_t current, uint32_t next, uint32_t far) {
+  uint32_t y = (current & kUpperMask) | (next & kLowerMask);
+  return far ^ (y >> 1u) ^ ((0u - (y & 1u)) & kMatrixA);
+}
+
+#ifdef __SSE2__
+// TwistWord on four consecutive words, state[i..i+3].
+inline void TwistWord4(uint32_t* state, size_t i, const uint32_t* far) {
+  const __m128i upper = _mm_set1_epi32(static_cast<int>(kUpperMask));
+  const __m128i lower = _mm_set1_epi32(static_cast<int>(kLowerMask));
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i matrix = _mm_set1_epi32(static_cast<int>(kMatrixA));
+
+  __m128i current =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + i));
+  __m128i next =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + i + 1));
+  __m128i far_vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(far));
+  __m128i y = _mm_or_si128(_mm_and_si128(current, upper),
+                           _mm_and_si128(next, lower));
+  // 0xffffffff where the low bit of y is set
+  __m128i odd = _mm_cmpeq_epi32(_mm_and_si128(y, one), one);
+  __m128i word = _mm_xor_si128(far_vec, _mm_srli_epi32(y, 1));
+  word = _mm_xor_si128(word, _mm_and_si128(odd, matrix));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state + i), word);
+}
+#endif
+
+}  // namespace
+
+void Mt19937::Seed(uint32_t seed) {
+  state_[0] = seed;
+  for (uint32_t i = 1; i < kN; i++) {
+    state_[i] =
+        kInitMultiplier * (state_[i - 1] ^ (state_[i - 1] >> 30u)) + i;
+  }
+  index_ = kN;
+}
+
+void Mt19937::Twist() {
+  // Word i reads the old words i and i + 1, and word i + kM which is old for
+  // i < kN - kM and was already regenerated after that. Within a group of
+  // four words these never overlap (kN - kM > 4), so the groups vectorize.
+  size_t i = 0;
+#ifdef __SSE2__
+  for (; i + 4 <= kN - kM; i += 4) {
+    TwistWord4(state_, i, state_ + i + kM);
+  }
+#endif
+  for (; i < kN - kM; i++) {
+    state_[i] = TwistWord(state_[i], state_[i + 1], state_[i + kM]);
+  }
+#ifdef __SSE2__
+  static_assert((kM - 1) % 4 == 0, "words kN - kM .. kN - 2 come in fours");
+  for (; i < kN - 1; i += 4) {
+    TwistWord4(state_, i, state_ + i - (kN - kM));
+  }
+#else
+  for (; i < kN - 1; i++) {
+    state_[i] = TwistWord(state_[i], state_[i + 1], state_[i - (kN - kM)]);
+  }
+#endif
+  state_[kN - 1] = TwistWord(state_[kN - 1], state_[0], state_[kM - 1]);
+  index_ = 0;
+}
+
+uint32_t Mt19937::Next() {
+  if (index_ == kN) {
+    Twist();
+  }
+  return Temper(state_[index_++]);
+}
+
+uint32_t Mt19937::Temper(uint32_t y) {
+  y ^= y >> 11u;
+  y ^= (y << 7u) & 0x9d2c5680;
+  y ^= (y << 15u) & 0xefc60000;
+  y ^= y >> 18u;
+  return y;
+}
+
+uint32_t Mt19937::Untemper(uint32_t y) {
+  y ^= y >> 18u;
+  // y << 15 masked clears the low 15 bits, so one step restores all 32.
+  y ^= (y << 15u) & 0xefc60000;
+  // Each step recovers 7 more low bits.
+  uint32_t x = y;
+  for (int i = 0; i < 4; i++) {
+    x = y ^ ((x << 7u) & 0x9d2c5680);
+  }
+  y = x;
+  // Each step recovers 11 more high bits.
+  x = y;
+  for (int i = 0; i < 2; i++) {
+    x = y ^ (x >> 11u);
+  }
+  return x;
+}
+
+Mt19937 Mt19937::FromOutputs(absl::Span<const uint32_t> outputs) {
+  if (outputs.size() < kN) {
+    throw std::invalid_argument("need 624 outputs");
+  }
+  Mt19937 mt;
+  for (size_t i = 0; i < kN; i++) {
+    mt.state_[i] = Untemper(outputs[i]);
+  }
+  mt.index_ = kN;
+  return mt;
+}
+
+namespace {
+
+constexpr size_t kLanes = 8;
+
+// Writes the first output of Mt19937(seeds[j]) to first_outputs[j]. The
+// lanes run in lockstep so the compiler can vectorize the seeding recurrence.
+void FirstOutputs(const uint32_t* seeds, uint32_t* first_outputs) {
+  uint32_t x[kLanes], x0[kLanes], x1[kLanes];
+  for (size_t j = 0; j < kLanes; j++) {
+    x0[j] = seeds[j];
+    x[j] = x1[j] = kInitMultiplier * (x0[j] ^ (x0[j] >> 30u)) + 1;
+  }
+  for (uint32_t i = 2; i <= kM; i++) {
+    for (size_t j = 0; j < kLanes; j++) {
+      x[j] = kInitMultiplier * (x[j] ^ (x[j] >> 30u)) + i;
+    }
+  }
+  for (size_t j = 0; j < kLanes; j++) {
+    first_outputs[j] = Mt19937::Temper(TwistWord(x0[j], x1[j], x[j]));
+  }
+}
+
+bool Matches(uint32_t seed, absl::Span<const uint32_t> outputs) {
+  Mt19937 mt(seed);
+  for (uint32_t output : outputs) {
+    if (mt.Next() != output) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+SeedSearchResult FindMt19937Seed(absl::Span<const uint32_t> outputs,
+                                 uint32_t first, uint32_t last,
+                                 unsigned threads) {
+  if (outputs.empty()) {
+    throw std::invalid_argument("no outputs to match");
+  }
+  if (first > last) {
+    throw std::invalid_argument("empty seed range");
+  }
+  const auto start = std::chrono::steady_clock::now();
+  const uint64_t count = uint64_t{last} - first + 1;
+  std::atomic<bool> found{false};
+  std::atomic<uint32_t> found_seed{0};
+  std::atomic<uint64_t> tested{0};
+
+  ParallelFor(
+      count, /*grain=*/1u << 16u,
+      [&](size_t begin, size_t end) {
+        if (found.load(std::memory_order_relaxed)) {
+          return;
+        }
+        uint32_t seeds[kLanes], first_outputs[kLanes];
+        for (size_t k = begin; k < end; k += kLanes) {
+          size_t lanes = std::min(kLanes, end - k);
+          for (size_t j = 0; j < kLanes; j++) {
+            // Pad a short last group with its first seed.
+            seeds[j] = static_cast<uint32_t>(first + k + (j < lanes ? j : 0));
+          }
+          FirstOutputs(seeds, first_outputs);
+          for (size_t j = 0; j < lanes; j++) {
+            if (first_outputs[j] == outputs[0] && Matches(seeds[j], outputs)) {
+              found_seed.store(seeds[j]);
+              found.store(true);
+            }
+          }
+        }
+        tested.fetch_add(end - begin, std::memory_order_relaxed);
+      },
+      threads);
+
+  SeedSearchResult result;
+  if (found.load()) {
+    result.seed = found_seed.load();
+  }
+  result.seeds_tested = tested.load();
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return result;
+}
+
+}  // namespace cryptopals::util
@@ -0,0 +1,61 @@
+#ifndef CRYPTOPALS_SET2_MT19937_H_
+#define CRYPTOPALS_SET2_MT19937_H_
+
+#include <cstdint>
+#include <optional>
+
+#include "absl/types/span.h"
+
+namespace cryptopals::util {
+
+// The 32-bit Mersenne Twister, producing the same sequence as std::mt19937.
+// Unlike the standard engine, the state is exposed for cloning from outputs.
+class Mt19937 {
+ public:
+  static constexpr size_t kStateSize = 624;
+  static constexpr uint32_t kDefaultSeed = 5489;
+
+  explicit Mt19937(uint32_t seed = kDefaultSeed) { Seed(seed); }
+
+  void Seed(uint32_t seed);
+  uint32_t Next();
+  uint32_t operator()() { return Next(); }
+
+  static uint32_t Temper(uint32_t y);
+  // Inverse of Temper.
+  static uint32_t Untemper(uint32_t y);
+  // Rebuilds a generator from kStateSize consecutive outputs; the clone
+  // produces the outputs that follow them.
+  static Mt19937 FromOutputs(absl::Span<const uint32_t> outputs);
+
+ private:
+  // Regenerates all kStateSize words of the state.
+  void Twist();
+
+  uint32_t state_[kStateSize];
+  size_t index_;
+};
+
+struct SeedSearchResult {
+  std::optional<uint32_t> seed;
+  uint64_t seeds_tested;
+  double seconds;
+
+  double SeedsPerSecond() const {
+    return seconds > 0 ? static_cast<double>(seeds_tested) / seconds : 0;
+  }
+};
+
+// Searches seeds in [first, last] for one whose Mt19937 starts with
+// `outputs`, e.g. a window of timestamps around when the generator was
+// seeded. Candidates are filtered on the first output, which only needs
+// a third of the seeding and none of the full twist, then confirmed against
+// all `outputs`. The range is split across `threads` (0 means all cores)
+// and the search stops at the first match.
+SeedSearchResult FindMt19937Seed(absl::Span<const uint32_t> outputs,
+                                 uint32_t first, uint32_t last,
+                                 unsigned threads = 0);
+
+}  // namespace cryptopals::util
+
+#endif  // CRYPTOPALS_SET2_MT19937_H_
@@ -0,0 +1,66 @@
+#include "mt19937.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace cryptopals::util {
+namespace {
+
+TEST(Mt19937Test, MatchesStdMt19937) {
+  for (uint32_t seed : {Mt19937::kDefaultSeed, 0u, 1u, 0xdeadbeefu}) {
+    Mt19937 mt(seed);
+    std::mt19937 reference(seed);
+    // Several twists
+    for (int i = 0; i < 5000; i++) {
+      ASSERT_EQ(reference(), mt()) << "seed " << seed << ", output " << i;
+    }
+  }
+  // 10000th output of the default seed, required by the standard.
+  Mt19937 mt;
+  uint32_t output = 0;
+  for (int i = 0; i < 10000; i++) output = mt();
+  EXPECT_EQ(4123659995u, output);
+}
+
+TEST(Mt19937Test, Untemper) {
+  std::mt19937 gen(42);
+  for (int i = 0; i < 1000; i++) {
+    uint32_t y = gen();
+    EXPECT_EQ(y, Mt19937::Untemper(Mt19937::Temper(y)));
+  }
+}
+
+TEST(Mt19937Test, FromOutputs) {
+  Mt19937 mt(1234);
+  for (int i = 0; i < 100; i++) mt();
+  std::vector<uint32_t> outputs(Mt19937::kStateSize);
+  for (auto& output : outputs) output = mt();
+  Mt19937 clone = Mt19937::FromOutputs(outputs);
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(mt(), clone());
+  }
+}
+
+TEST(Mt19937Test, FindSeed) {
+  const uint32_t timestamp = 1600000000;
+  Mt19937 mt(timestamp);
+  std::vector<uint32_t> outputs = {mt(), mt(), mt()};
+
+  auto result = FindMt19937Seed(outputs, timestamp - 100000, timestamp + 1000);
+  ASSERT_TRUE(result.seed.has_value());
+  EXPECT_EQ(timestamp, *result.seed);
+  EXPECT_GT(result.seeds_tested, 0);
+
+  // Edges of the range, single-threaded
+  result = FindMt19937Seed(outputs, timestamp, timestamp, /*threads=*/1);
+  EXPECT_EQ(timestamp, result.seed);
+  EXPECT_EQ(1, result.seeds_tested);
+  result = FindMt19937Seed(outputs, timestamp - 20, timestamp - 1);
+  EXPECT_FALSE(result.seed.has_value());
+  EXPECT_EQ(20, result.seeds_tested);
+}
+
+}  // namespace
+}  // namespace cryptopals::util
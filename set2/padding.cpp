@@ -2,14 +2,28 @@
 
 #include <cassert>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace cryptopals {
 
+namespace {
+
+// Returns 0xff if a < b, 0x00 otherwise, without branching on the values.
+uint8_t LessThanMask(uint32_t a, uint32_t b) {
+  return static_cast<uint8_t>(0u - ((a - b) >> 31u));
+}
+
+}  // namespace
+
 // https://tools.ietf.org/html/rfc2315#section-10.3
 std::string Padding::Pkcs7Encode(std::string_view input, uint8_t block_size) {
-  assert(block_size > 1);
-  uint8_t pad = block_size - input.size() % block_size;
-  std::string tail(/*size=*/pad, /*char=*/pad);
-  return std::string(input) + tail;
+  std::string output;
+  output.reserve(input.size() + block_size);
+  output.append(input);
+  Pkcs7Pad(&output, block_size);
+  return output;
 }
 
 std::string Padding::Pkcs7Decode(std::string_view input) {
@@ -17,4 +31,57 @@ std::string Padding::Pkcs7Decode(std::string_view input) {
   return std::string(input.substr(0, input.size() - padding_length));
 }
 
-}  // namespace cryptopals
\ No newline at end of file
+void Padding::Pkcs7Pad(std::string* buffer, uint8_t block_size) {
+  assert(block_size > 1);
+  uint8_t pad = block_size - buffer->size() % block_size;
+  buffer->append(/*count=*/pad, /*char=*/pad);
+}
+
+std::optional<std::string_view> Padding::Pkcs7Unpad(std::string_view input,
+                                                    uint8_t block_size) {
+  assert(block_size > 1);
+  // Sizes are public, only the content needs to be handled in constant time.
+  if (input.empty() || input.size() % block_size != 0) {
+    return std::nullopt;
+  }
+  const auto* tail = reinterpret_cast<const uint8_t*>(input.data()) +
+                     input.size() - block_size;
+  uint8_t pad = tail[block_size - 1];
+  // Non-zero if pad == 0 or pad > block_size
+  uint8_t bad = static_cast<uint8_t>(~LessThanMask(0, pad)) |
+                LessThanMask(block_size, pad);
+
+#ifdef __SSE2__
+  if (block_size == 16) {
+    // Compare the whole block against `pad` at once, then ignore the leading
+    // bytes which are not part of the padding.
+    const __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(tail));
+    const __m128i pad_vec = _mm_set1_epi8(static_cast<char>(pad));
+    const __m128i index = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+                                        12, 13, 14, 15);
+    // index >= 16 - pad, i.e. index > 15 - pad
+    const __m128i in_padding =
+        _mm_cmpgt_epi8(index, _mm_set1_epi8(static_cast<char>(15 - pad)));
+    const __m128i ok = _mm_or_si128(_mm_cmpeq_epi8(block, pad_vec),
+                                    _mm_andnot_si128(in_padding,
+                                                     _mm_set1_epi8(-1)));
+    bad |= static_cast<uint8_t>(_mm_movemask_epi8(ok) != 0xffff);
+    if (bad) {
+      return std::nullopt;
+    }
+    return input.substr(0, input.size() - pad);
+  }
+#endif
+
+  for (uint32_t i = 0; i < block_size; i++) {
+    // The i-th byte from the end is padding if i < pad.
+    bad |= LessThanMask(i, pad) & (tail[block_size - 1 - i] ^ pad);
+  }
+  if (bad) {
+    return std::nullopt;
+  }
+  return input.substr(0, input.size() - pad);
+}
+
+}  // namespace cryptopals
@@ -1,6 +1,7 @@
 #ifndef CRYPTOPALS_SET2_PADDING_H_
 #define CRYPTOPALS_SET2_PADDING_H_
 
+#include <optional>
 #include <string>
 #include <string_view>
 
@@ -10,6 +11,17 @@ class Padding {
  public:
   static std::string Pkcs7Encode(std::string_view input, uint8_t block_size);
   static std::string Pkcs7Decode(std::string_view input);
+
+  // In-place variants of the above.
+  // Pkcs7Pad appends the padding to `buffer`, which never reallocates if the
+  // caller reserved `block_size` extra bytes of capacity.
+  static void Pkcs7Pad(std::string* buffer, uint8_t block_size);
+  // Pkcs7Unpad returns `input` without its padding, as a view into `input`.
+  // All padding bytes are validated in constant time with respect to their
+  // content; returns std::nullopt if the padding is invalid or `input` is not
+  // aligned with `block_size`.
+  static std::optional<std::string_view> Pkcs7Unpad(std::string_view input,
+                                                    uint8_t block_size);
 };
 
 }  // namespace cryptopals
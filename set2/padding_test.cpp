@@ -18,5 +18,53 @@ TEST(Pkcs7Test, Circling) {
   }
 }
 
+TEST(Pkcs7Test, PadInPlace) {
+  std::string buffer = "YELLOW SUBMARINE";
+  buffer.reserve(buffer.size() + 16);
+  const char* data = buffer.data();
+  Padding::Pkcs7Pad(&buffer, 16);
+  EXPECT_EQ("YELLOW SUBMARINE" + std::string(16, 16), buffer);
+  EXPECT_EQ(data, buffer.data());  // no reallocation
+}
+
+TEST(Pkcs7Test, UnpadCircling) {
+  std::string input = "YELLOW SUBMARINE";
+  for (uint32_t block_size = 2; block_size < 1u << 8u; block_size++) {
+    for (size_t size = 0; size <= input.size(); size++) {
+      std::string buffer = input.substr(0, size);
+      Padding::Pkcs7Pad(&buffer, block_size);
+      auto unpadded = Padding::Pkcs7Unpad(buffer, block_size);
+      ASSERT_TRUE(unpadded.has_value());
+      EXPECT_EQ(input.substr(0, size), *unpadded);
+      EXPECT_EQ(buffer.data(), unpadded->data());  // view, not a copy
+    }
+  }
+}
+
+TEST(Pkcs7Test, UnpadInvalid) {
+  for (uint8_t block_size : {8, 16}) {
+    std::string block(block_size, 'A');
+    EXPECT_FALSE(Padding::Pkcs7Unpad(block, block_size).has_value());
+    block.back() = 0;
+    EXPECT_FALSE(Padding::Pkcs7Unpad(block, block_size).has_value());
+    block.back() = block_size + 1;
+    EXPECT_FALSE(Padding::Pkcs7Unpad(block, block_size).has_value());
+    // "...\x03\x02\x03"
+    block.back() = 3;
+    block[block_size - 2] = 2;
+    block[block_size - 3] = 3;
+    EXPECT_FALSE(Padding::Pkcs7Unpad(block, block_size).has_value());
+    block[block_size - 2] = 3;
+    EXPECT_EQ(block.substr(0, block_size - 3),
+              Padding::Pkcs7Unpad(block, block_size));
+    // Not aligned with the block size
+    EXPECT_FALSE(Padding::Pkcs7Unpad(block.substr(1), block_size).has_value());
+    EXPECT_FALSE(Padding::Pkcs7Unpad("", block_size).has_value());
+  }
+  // Whole block of padding
+  std::string full(16, 16);
+  EXPECT_EQ("", Padding::Pkcs7Unpad(full, 16));
+}
+
 }  // namespace
 }  // namespace cryptopals
\ No newline at end of file
@@ -1,18 +1,117 @@
 #include "rand_util.h"
 
 #include <algorithm>
+#include <cassert>
 #include <climits>
+#include <cstring>
 #include <random>
+#include <stdexcept>
 
 namespace cryptopals::util {
 
-std::string RandStr(uint8_t length) {
-  std::independent_bits_engine<std::default_random_engine, CHAR_BIT,
-                               unsigned char>
-      random_byte_engine(std::random_device{}());
+CtrDrbg& CtrDrbg::ThreadLocal() {
+  thread_local CtrDrbg drbg;
+  return drbg;
+}
+
+CtrDrbg::CtrDrbg() {
+  // The only system call, once per generator.
+  std::random_device device;
+  uint8_t seed[kSeedSize];
+  for (size_t i = 0; i < kSeedSize; i += sizeof(uint32_t)) {
+    uint32_t word = device();
+    std::memcpy(seed + i, &word, sizeof(word));
+  }
+  Init(seed);
+}
+
+CtrDrbg::CtrDrbg(std::string_view seed) {
+  if (seed.size() != kSeedSize) {
+    throw std::invalid_argument("invalid seed size");
+  }
+  Init(reinterpret_cast<const uint8_t*>(seed.data()));
+}
+
+CtrDrbg::~CtrDrbg() { EVP_CIPHER_CTX_free(ctx_); }
+
+void CtrDrbg::Init(const uint8_t* seed) {
+  ctx_ = EVP_CIPHER_CTX_new();
+  // The full 128-bit block is the counter, there's no nonce.
+  if (ctx_ == nullptr || EVP_EncryptInit_ex(ctx_, EVP_aes_128_ctr(), nullptr,
+                                            seed, seed + 16) != 1) {
+    throw std::runtime_error("cannot initialize AES-CTR");
+  }
+}
+
+void CtrDrbg::Generate(uint8_t* out, size_t size) {
+  // Key stream == encryption of zeros.
+  std::memset(out, 0, size);
+  while (size > 0) {
+    int len = static_cast<int>(std::min<size_t>(size, INT_MAX / 2));
+    int out_len = 0;
+    if (EVP_EncryptUpdate(ctx_, out, &out_len, out, len) != 1 ||
+        out_len != len) {
+      // Never hand out the zeroed buffer as random bytes.
+      throw std::runtime_error("AES-CTR key stream generation failed");
+    }
+    out += len;
+    size -= len;
+  }
+}
+
+void CtrDrbg::Fill(absl::Span<uint8_t> out) {
+  while (!out.empty()) {
+    if (pos_ == kBufferSize) {
+      if (out.size() >= kBufferSize) {
+        // Bulk request, skip the buffer.
+        size_t bulk = out.size() / kBufferSize * kBufferSize;
+        Generate(out.data(), bulk);
+        out.remove_prefix(bulk);
+        continue;
+      }
+      Generate(buffer_, kBufferSize);
+      pos_ = 0;
+    }
+    size_t n = std::min(out.size(), kBufferSize - pos_);
+    std::memcpy(out.data(), buffer_ + pos_, n);
+    pos_ += n;
+    out.remove_prefix(n);
+  }
+}
+
+uint32_t CtrDrbg::NextU32() {
+  uint32_t val;
+  Fill(absl::MakeSpan(reinterpret_cast<uint8_t*>(&val), sizeof(val)));
+  return val;
+}
+
+// Lemire's nearly divisionless method, see https://arxiv.org/abs/1805.10941
+uint32_t CtrDrbg::Uniform(uint32_t lo, uint32_t hi) {
+  assert(lo <= hi);
+  uint32_t range = hi - lo + 1;
+  if (range == 0) {
+    return NextU32();  // [0, 2^32)
+  }
+  uint64_t m = static_cast<uint64_t>(NextU32()) * range;
+  if (static_cast<uint32_t>(m) < range) {
+    uint32_t threshold = (0u - range) % range;
+    while (static_cast<uint32_t>(m) < threshold) {
+      m = static_cast<uint64_t>(NextU32()) * range;
+    }
+  }
+  return lo + static_cast<uint32_t>(m >> 32u);
+}
+
+std::string RandStr(size_t length) {
   std::string str(length, 0);
-  std::generate(str.begin(), str.end(), random_byte_engine);
+  RandFill(absl::MakeSpan(reinterpret_cast<uint8_t*>(str.data()), length));
   return str;
 }
 
-}  // namespace cryptopals::util
\ No newline at end of file
+void RandFill(absl::Span<uint8_t> out) { CtrDrbg::ThreadLocal().Fill(out); }
+
+uint32_t RandUniform(uint32_t lo, uint32_t hi) {
+  return CtrDrbg::ThreadLocal().Uniform(lo, hi);
+}
+
+}  // namespace cryptopals::util
@@ -1,11 +1,59 @@
 #ifndef CRYPTOPALS_SET2_RAND_UTIL_H_
 #define CRYPTOPALS_SET2_RAND_UTIL_H_
 
+#include <openssl/evp.h>
+
+#include <cstdint>
 #include <string>
+#include <string_view>
+
+#include "absl/types/span.h"
 
 namespace cryptopals::util {
 
-std::string RandStr(uint8_t length);
+// AES-128-CTR deterministic random bit generator.
+//
+// The key stream is produced in bulk into an internal buffer, so drawing a
+// few random bytes is a memcpy, and large requests are generated directly
+// into the caller's memory. Use ThreadLocal() for a generator seeded once per
+// thread from the OS; the seeded constructor is for reproducible runs.
+class CtrDrbg {
+ public:
+  static constexpr size_t kSeedSize = 32;  // 128-bit key, 128-bit counter
+
+  // The generator of the calling thread.
+  static CtrDrbg& ThreadLocal();
+
+  // Seeded from std::random_device.
+  CtrDrbg();
+  // `seed` needs to be kSeedSize bytes.
+  explicit CtrDrbg(std::string_view seed);
+  ~CtrDrbg();
+  CtrDrbg(const CtrDrbg&) = delete;
+  CtrDrbg& operator=(const CtrDrbg&) = delete;
+
+  void Fill(absl::Span<uint8_t> out);
+  uint32_t NextU32();
+  // Uniformly distributed in [lo, hi].
+  uint32_t Uniform(uint32_t lo, uint32_t hi);
+
+ private:
+  static constexpr size_t kBufferSize = 4096;
+
+  void Init(const uint8_t* seed);
+  // Writes the next `size` bytes of key stream into `out`.
+  void Generate(uint8_t* out, size_t size);
+
+  EVP_CIPHER_CTX* ctx_ = nullptr;
+  uint8_t buffer_[kBufferSize];
+  size_t pos_ = kBufferSize;  // next unused byte in `buffer_`
+};
+
+// Helpers drawing from CtrDrbg::ThreadLocal().
+std::string RandStr(size_t length);
+void RandFill(absl::Span<uint8_t> out);
+// Uniformly distributed in [lo, hi].
+uint32_t RandUniform(uint32_t lo, uint32_t hi);
 
 }  // namespace cryptopals::util
 
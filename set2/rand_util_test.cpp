@@ -0,0 +1,71 @@
+#include "rand_util.h"
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace cryptopals::util {
+namespace {
+
+TEST(CtrDrbgTest, SameSeedSameStream) {
+  std::string seed(CtrDrbg::kSeedSize, 's');
+  CtrDrbg drbg1(seed), drbg2(seed);
+  std::vector<uint8_t> out1(10000), out2(10000);
+  drbg1.Fill(absl::MakeSpan(out1));
+  // Small draws from the buffer and bulk draws mixed together should still
+  // produce the same stream.
+  size_t pos = 0;
+  for (size_t size : {1, 7, 4090, 5000, 902}) {
+    drbg2.Fill(absl::MakeSpan(out2).subspan(pos, size));
+    pos += size;
+  }
+  ASSERT_EQ(out1.size(), pos);
+  EXPECT_EQ(out1, out2);
+}
+
+// AES-128-CTR key stream from a zero counter, i.e. AES-ECB of the blocks
+// 0, 1, 2, ... under the key.
+TEST(CtrDrbgTest, AesCtrKeyStream) {
+  std::string seed(CtrDrbg::kSeedSize, 0);
+  CtrDrbg drbg(seed);
+  std::vector<uint8_t> out(16);
+  drbg.Fill(absl::MakeSpan(out));
+  // AES-128(key = 0^128, block = 0^128)
+  std::vector<uint8_t> expected = {0x66, 0xe9, 0x4b, 0xd4, 0xef, 0x8a,
+                                   0x2c, 0x3b, 0x88, 0x4c, 0xfa, 0x59,
+                                   0xca, 0x34, 0x2b, 0x2e};
+  EXPECT_EQ(expected, out);
+}
+
+TEST(CtrDrbgTest, Uniform) {
+  CtrDrbg drbg(std::string(CtrDrbg::kSeedSize, 'u'));
+  std::vector<int> counts(6);
+  for (int i = 0; i < 6000; i++) {
+    uint32_t val = drbg.Uniform(5, 10);
+    ASSERT_GE(val, 5);
+    ASSERT_LE(val, 10);
+    counts[val - 5]++;
+  }
+  for (int count : counts) {
+    // mean 1000, sigma ~ 29
+    EXPECT_GT(count, 850);
+    EXPECT_LT(count, 1150);
+  }
+  EXPECT_EQ(7, drbg.Uniform(7, 7));
+  drbg.Uniform(0, UINT32_MAX);
+}
+
+TEST(RandUtilTest, ThreadsHaveIndependentStreams) {
+  std::string str1, str2;
+  std::thread t1([&str1]() { str1 = RandStr(32); });
+  std::thread t2([&str2]() { str2 = RandStr(32); });
+  t1.join();
+  t2.join();
+  EXPECT_EQ(32, str1.size());
+  EXPECT_NE(str1, str2);
+  EXPECT_NE(RandStr(1000), RandStr(1000));
+}
+
+}  // namespace
+}  // namespace cryptopals::util
@@ -0,0 +1,94 @@
+#include "fixed_nonce_ctr.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "../set1/single_byte_xor_cipher.h"
+#include "../util/parallel.h"
+
+namespace cryptopals {
+
+namespace {
+
+// Columns transposed and solved by one task. A task reads this many bytes
+// from every row long enough, so rows are touched once per task.
+constexpr size_t kColumnsPerTask = 16;
+
+}  // namespace
+
+FixedNonceCtrBreak BreakFixedNonceCtr(std::string_view buffer,
+                                      const std::vector<size_t>& offsets,
+                                      unsigned threads) {
+  FixedNonceCtrBreak result;
+  if (offsets.size() < 2) {
+    return result;
+  }
+  const size_t count = offsets.size() - 1;
+  auto length = [&offsets](size_t i) { return offsets[i + 1] - offsets[i]; };
+
+  // Rows in order of decreasing length, so column j is made of the first
+  // column_sizes[j] rows.
+  std::vector<size_t> order(count);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return length(a) > length(b);
+  });
+  const size_t longest = length(order[0]);
+  result.column_sizes.assign(longest, 0);
+  for (size_t i = 0; i < count; i++) {
+    // Counted at the last column of the row, summed backwards below.
+    if (length(i) > 0) result.column_sizes[length(i) - 1]++;
+  }
+  for (size_t j = longest; j-- > 1;) {
+    result.column_sizes[j - 1] += result.column_sizes[j];
+  }
+
+  std::vector<size_t> column_offsets(longest + 1, 0);
+  for (size_t j = 0; j < longest; j++) {
+    column_offsets[j + 1] = column_offsets[j] + result.column_sizes[j];
+  }
+  std::string columns(column_offsets.back(), 0);
+  result.key_stream.resize(longest);
+
+  // Every task owns a range of columns: it fills their slice of the
+  // column-major buffer and writes their key stream bytes, so the result
+  // does not depend on scheduling.
+  const size_t tasks = (longest + kColumnsPerTask - 1) / kColumnsPerTask;
+  util::ParallelFor(
+      tasks, 1,
+      [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++) {
+          const size_t first = t * kColumnsPerTask;
+          const size_t last = std::min(longest, first + kColumnsPerTask);
+          for (size_t r = 0; r < result.column_sizes[first]; r++) {
+            const char* row = buffer.data() + offsets[order[r]];
+            const size_t row_end = std::min(last, length(order[r]));
+            for (size_t j = first; j < row_end; j++) {
+              columns[column_offsets[j] + r] = row[j];
+            }
+          }
+          for (size_t j = first; j < last; j++) {
+            std::string_view column(&columns[column_offsets[j]],
+                                    result.column_sizes[j]);
+            double score;
+            result.key_stream[j] = static_cast<char>(BestSingleByteXorKey(
+                BuildByteHistogram(column), column.size(), &score));
+          }
+        }
+      },
+      threads);
+  return result;
+}
+
+FixedNonceCtrBreak BreakFixedNonceCtr(
+    const std::vector<std::string>& ciphertexts, unsigned threads) {
+  std::string buffer;
+  std::vector<size_t> offsets = {0};
+  for (const auto& ciphertext : ciphertexts) {
+    buffer += ciphertext;
+    offsets.push_back(buffer.size());
+  }
+  return BreakFixedNonceCtr(buffer, offsets, threads);
+}
+
+}  // namespace cryptopals
@@ -0,0 +1,40 @@
+#ifndef CRYPTOPALS_SET3_FIXED_NONCE_CTR_H_
+#define CRYPTOPALS_SET3_FIXED_NONCE_CTR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cryptopals {
+
+// Messages encrypted under one key with a fixed nonce all share the same CTR
+// key stream, so byte j of every ciphertext is byte j of its plaintext XOR
+// the same key stream byte. Column j, made of byte j of all ciphertexts long
+// enough to have one, is a single-byte XOR cipher.
+struct FixedNonceCtrBreak {
+  // Byte j is the best single-byte XOR key of column j. As long as the
+  // longest ciphertext; trailing columns with few samples are unreliable.
+  std::string key_stream;
+  // Number of ciphertexts that contributed to each column.
+  std::vector<uint32_t> column_sizes;
+};
+
+// Lays the ciphertexts out column-major (ragged lengths are fine: shorter
+// ciphertexts simply drop out of the later columns) and solves the columns
+// in parallel on `threads` workers (0 means all cores). Each column is scored
+// from its byte histogram against the letter_freq model. The result does not
+// depend on the number of threads.
+//
+// Ciphertext i is buffer[offsets[i], offsets[i + 1]), `offsets` holds one
+// more entry than there are ciphertexts.
+FixedNonceCtrBreak BreakFixedNonceCtr(std::string_view buffer,
+                                      const std::vector<size_t>& offsets,
+                                      unsigned threads = 0);
+FixedNonceCtrBreak BreakFixedNonceCtr(
+    const std::vector<std::string>& ciphertexts, unsigned threads = 0);
+
+}  // namespace cryptopals
+
+#endif  // CRYPTOPALS_SET3_FIXED_NONCE_CTR_H_
@@ -0,0 +1,64 @@
+#include "fixed_nonce_ctr.h"
+
+#include "../set1/fixed_xor.h"
+#include "../set2/aes.h"
+#include "../util/mapped_file.h"
+#include "gtest/gtest.h"
+
+namespace cryptopals {
+namespace {
+
+constexpr size_t kMaxLength = 160;
+
+std::string KeyStream() {
+  return Aes::CtrKeyStream("YELLOW SUBMARINE", std::string(4, 0),
+                           std::string(8, 0), 1, kMaxLength);
+}
+
+// English messages of ragged lengths cut from the corpus, all encrypted
+// under the same key stream.
+std::vector<std::string> Ciphertexts(size_t count) {
+  const auto corpus = util::MappedFile::OpenData("1984.txt");
+  std::string_view text = corpus.data();
+  const std::string key_stream = KeyStream();
+  std::vector<std::string> ciphertexts;
+  uint32_t x = 1;
+  for (size_t i = 0; i < count; i++) {
+    x = x * 1103515245 + 12345;
+    size_t length = 1 + (x >> 8u) % kMaxLength;
+    size_t pos = (x >> 4u) % (text.size() - length);
+    ciphertexts.push_back(FixedXor(text.substr(pos, length), key_stream));
+  }
+  return ciphertexts;
+}
+
+TEST(FixedNonceCtrTest, RecoversKeyStream) {
+  auto ciphertexts = Ciphertexts(100000);
+  FixedNonceCtrBreak result = BreakFixedNonceCtr(ciphertexts);
+  ASSERT_EQ(kMaxLength, result.key_stream.size());
+  ASSERT_EQ(kMaxLength, result.column_sizes.size());
+  EXPECT_EQ(ciphertexts.size(), result.column_sizes[0]);
+  EXPECT_GT(result.column_sizes[kMaxLength - 1], 0);
+  // Even the last column holds hundreds of samples here.
+  EXPECT_EQ(KeyStream(), result.key_stream);
+
+  for (unsigned threads : {1, 3}) {
+    EXPECT_EQ(result.key_stream,
+              BreakFixedNonceCtr(ciphertexts, threads).key_stream);
+  }
+}
+
+TEST(FixedNonceCtrTest, RaggedColumns) {
+  FixedNonceCtrBreak result =
+      BreakFixedNonceCtr({"abc", "", "a", "abcde", "ab"});
+  EXPECT_EQ(5, result.key_stream.size());
+  EXPECT_EQ(std::vector<uint32_t>({4, 3, 2, 1, 1}), result.column_sizes);
+
+  result = BreakFixedNonceCtr(std::vector<std::string>{});
+  EXPECT_TRUE(result.key_stream.empty());
+  result = BreakFixedNonceCtr({"", ""});
+  EXPECT_TRUE(result.key_stream.empty());
+}
+
+}  // namespace
+}  // namespace cryptopals
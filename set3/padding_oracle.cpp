@@ -0,0 +1,147 @@
+#include "padding_oracle.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+#include "../set2/aes.h"
+#include "../set2/padding.h"
+#include "../set2/rand_util.h"
+#include "../util/parallel.h"
+
+namespace cryptopals {
+
+namespace {
+
+constexpr size_t kBlockSize = 16;
+
+// Recovers the AES decryption of `block`, i.e. its plaintext XOR `prev`, by
+// forging the block before it. Byte 15 is found first with padding 0x01, then
+// byte 14 with 0x02 0x02 and so on.
+std::string RecoverIntermediate(PaddingOracle* oracle, std::string_view block,
+                                unsigned lanes,
+                                PaddingOracleBlockReport* report) {
+  std::string intermediate(kBlockSize, 0);
+  std::string forged(kBlockSize, 0);
+  std::atomic<uint64_t> queries{0};
+  for (size_t pad = 1; pad <= kBlockSize; pad++) {
+    const size_t pos = kBlockSize - pad;
+    for (size_t k = pos + 1; k < kBlockSize; k++) {
+      forged[k] = static_cast<char>(intermediate[k] ^ pad);
+    }
+    std::atomic<int> found{-1};
+    util::ParallelFor(
+        256, 1,
+        [&](size_t begin, size_t end) {
+          for (size_t guess = begin; guess < end; guess++) {
+            if (found.load(std::memory_order_relaxed) >= 0) {
+              return;
+            }
+            std::string iv = forged;
+            iv[pos] = static_cast<char>(guess);
+            queries++;
+            if (!oracle->ValidPadding(iv, block)) {
+              continue;
+            }
+            if (pad == 1) {
+              // The plaintext may have ended in 0x02 0x02 (or longer valid
+              // padding) instead of 0x01; changing the byte before tells.
+              iv[pos - 1] ^= 1;
+              queries++;
+              if (!oracle->ValidPadding(iv, block)) {
+                continue;
+              }
+            }
+            found = static_cast<int>(guess);
+          }
+        },
+        lanes);
+    if (found < 0) {
+      throw std::runtime_error("padding oracle accepted no guess");
+    }
+    intermediate[pos] = static_cast<char>(found ^ static_cast<int>(pad));
+  }
+  report->queries = queries;
+  return intermediate;
+}
+
+}  // namespace
+
+CbcPaddingOracle::CbcPaddingOracle() : key_(util::RandStr(kBlockSize)) {}
+
+CbcPaddingOracle::Ciphertext CbcPaddingOracle::Encrypt(
+    std::string_view plaintext) const {
+  Ciphertext result;
+  result.iv = util::RandStr(kBlockSize);
+  result.ciphertext = Aes::CbcEncrypt(
+      Padding::Pkcs7Encode(plaintext, kBlockSize), key_, result.iv);
+  return result;
+}
+
+bool CbcPaddingOracle::ValidPadding(std::string_view iv,
+                                    std::string_view ciphertext) {
+  if (iv.size() != kBlockSize || ciphertext.empty() ||
+      ciphertext.size() % kBlockSize != 0) {
+    return false;
+  }
+  std::string plaintext = Aes::CbcDecrypt(ciphertext, key_, iv);
+  return Padding::Pkcs7Unpad(plaintext, kBlockSize).has_value();
+}
+
+uint64_t PaddingOracleResult::queries() const {
+  uint64_t total = 0;
+  for (const auto& block : blocks) {
+    total += block.queries;
+  }
+  return total;
+}
+
+PaddingOracleResult PaddingOracleDecrypt(PaddingOracle* oracle,
+                                         std::string_view iv,
+                                         std::string_view ciphertext,
+                                         unsigned max_in_flight) {
+  if (iv.size() != kBlockSize || ciphertext.size() % kBlockSize != 0) {
+    throw std::invalid_argument("ciphertext is not aligned with AES blocks");
+  }
+  const size_t count = ciphertext.size() / kBlockSize;
+  PaddingOracleResult result;
+  result.plaintext.resize(ciphertext.size());
+  result.blocks.resize(count);
+  if (count == 0) {
+    return result;
+  }
+  if (max_in_flight == 0) {
+    max_in_flight = util::DefaultThreadCount();
+  }
+  // Blocks first, the remaining parallelism goes to the guesses of a byte.
+  const auto block_workers =
+      static_cast<unsigned>(std::min<size_t>(count, max_in_flight));
+  const unsigned lanes = std::max(1u, max_in_flight / block_workers);
+
+  util::ParallelFor(
+      count, 1,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          const auto start = std::chrono::steady_clock::now();
+          std::string_view prev =
+              i == 0 ? iv : ciphertext.substr((i - 1) * kBlockSize, kBlockSize);
+          std::string intermediate =
+              RecoverIntermediate(oracle, ciphertext.substr(i * kBlockSize,
+                                                            kBlockSize),
+                                  lanes, &result.blocks[i]);
+          for (size_t k = 0; k < kBlockSize; k++) {
+            result.plaintext[i * kBlockSize + k] =
+                static_cast<char>(intermediate[k] ^ prev[k]);
+          }
+          result.blocks[i].seconds =
+              std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                            start)
+                  .count();
+        }
+      },
+      block_workers);
+  return result;
+}
+
+}  // namespace cryptopals
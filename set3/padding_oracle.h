@@ -0,0 +1,73 @@
+#ifndef CRYPTOPALS_SET3_PADDING_ORACLE_H_
+#define CRYPTOPALS_SET3_PADDING_ORACLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cryptopals {
+
+// Tells whether a CBC ciphertext decrypts to validly PKCS#7 padded plaintext,
+// and nothing else.
+class PaddingOracle {
+ public:
+  virtual ~PaddingOracle() = default;
+  // `iv` is one block, `ciphertext` whole blocks.
+  virtual bool ValidPadding(std::string_view iv,
+                            std::string_view ciphertext) = 0;
+};
+
+// Local stand-in: AES-128-CBC under a random key, checked with Aes::CbcDecrypt
+// and Padding::Pkcs7Unpad. Thread-safe.
+class CbcPaddingOracle : public PaddingOracle {
+ public:
+  CbcPaddingOracle();
+
+  // Pads and encrypts `plaintext` under a fresh random IV.
+  struct Ciphertext {
+    std::string iv;
+    std::string ciphertext;
+  };
+  Ciphertext Encrypt(std::string_view plaintext) const;
+
+  bool ValidPadding(std::string_view iv, std::string_view ciphertext) override;
+
+ private:
+  const std::string key_;
+};
+
+struct PaddingOracleBlockReport {
+  uint64_t queries = 0;
+  double seconds = 0;  // wall time from the first query to the last byte
+};
+
+struct PaddingOracleResult {
+  // Decrypted plaintext, padding included.
+  std::string plaintext;
+  // One entry per ciphertext block.
+  std::vector<PaddingOracleBlockReport> blocks;
+
+  uint64_t queries() const;
+};
+
+// Decrypts `ciphertext` through `oracle` (challenge 17). Block i only depends
+// on ciphertext blocks i - 1 and i, so all blocks are attacked at once. For
+// each byte the 256 guesses are handed out together to the workers of the
+// block, and they stop as soon as one of them has found the byte; a guess
+// that happens to produce longer valid padding is told apart with one more
+// query.
+//
+// At most `max_in_flight` queries are outstanding at any time (0 means all
+// cores); they are split among the blocks, so a slow but concurrent oracle is
+// kept busy. `oracle` must be thread-safe. Throws std::invalid_argument on a
+// misaligned ciphertext and std::runtime_error if no guess is accepted.
+PaddingOracleResult PaddingOracleDecrypt(PaddingOracle* oracle,
+                                         std::string_view iv,
+                                         std::string_view ciphertext,
+                                         unsigned max_in_flight = 0);
+
+}  // namespace cryptopals
+
+#endif  // CRYPTOPALS_SET3_PADDING_ORACLE_H_
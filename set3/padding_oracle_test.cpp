@@ -0,0 +1,172 @@
+#include "padding_oracle.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "../set2/padding.h"
+#include "../util/codec.h"
+#include "gtest/gtest.h"
+
+namespace cryptopals {
+namespace {
+
+constexpr const char* kStrings[] = {
+    "MDAwMDAwTm93IHRoYXQgdGhlIHBhcnR5IGlzIGp1bXBpbmc=",
+    "MDAwMDAxV2l0aCB0aGUgYmFzcyBraWNrZWQgaW4gYW5kIHRoZSBWZWdhJ3MgYXJlIHB1bXBp"
+    "bic=",
+    "MDAwMDAyUXVpY2sgdG8gdGhlIHBvaW50LCB0byB0aGUgcG9pbnQsIG5vIGZha2luZw==",
+    "MDAwMDAzQ29va2luZyBNQydzIGxpa2UgYSBwb3VuZCBvZiBiYWNvbg==",
+    "MDAwMDA0QnVybmluZyAnZW0sIGlmIHlvdSBhaW4ndCBxdWljayBhbmQgbmltYmxl",
+    "MDAwMDA1SSBnbyBjcmF6eSB3aGVuIEkgaGVhciBhIGN5bWJhbA==",
+    "MDAwMDA2QW5kIGEgaGlnaCBoYXQgd2l0aCBhIHNvdXBlZCB1cCB0ZW1wbw==",
+    "MDAwMDA3SSdtIG9uIGEgcm9sbCwgaXQncyB0aW1lIHRvIGdvIHNvbG8=",
+    "MDAwMDA4b2xsaW4nIGluIG15IGZpdmUgcG9pbnQgb2g=",
+    "MDAwMDA5aXRoIG15IHJhZy10b3AgZG93biBzbyBteSBoYWlyIGNhbiBibG93",
+};
+
+// Adds a fixed round trip to every query and records how many were served
+// at once.
+class SlowOracle : public PaddingOracle {
+ public:
+  SlowOracle(PaddingOracle* oracle, std::chrono::microseconds latency)
+      : oracle_(oracle), latency_(latency) {}
+
+  bool ValidPadding(std::string_view iv,
+                    std::string_view ciphertext) override {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      peak_ = std::max(peak_, ++in_flight_);
+    }
+    std::this_thread::sleep_for(latency_);
+    bool valid = oracle_->ValidPadding(iv, ciphertext);
+    std::lock_guard<std::mutex> lock(mu_);
+    in_flight_--;
+    return valid;
+  }
+
+  size_t peak() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return peak_;
+  }
+
+ private:
+  PaddingOracle* const oracle_;
+  const std::chrono::microseconds latency_;
+  std::mutex mu_;
+  size_t in_flight_ = 0;
+  size_t peak_ = 0;
+};
+
+TEST(PaddingOracleTest, StandIn) {
+  CbcPaddingOracle oracle;
+  auto encrypted = oracle.Encrypt("YELLOW SUBMARINE");
+  EXPECT_EQ(32, encrypted.ciphertext.size());
+  EXPECT_TRUE(oracle.ValidPadding(encrypted.iv, encrypted.ciphertext));
+  encrypted.ciphertext[15] ^= 1;  // last plaintext byte is no longer 0x10
+  EXPECT_FALSE(oracle.ValidPadding(encrypted.iv, encrypted.ciphertext));
+  EXPECT_FALSE(oracle.ValidPadding(encrypted.iv, "misaligned"));
+}
+
+TEST(PaddingOracleTest, DecryptsChallengeStrings) {
+  CbcPaddingOracle oracle;
+  for (const char* base64 : kStrings) {
+    std::string plaintext;
+    ASSERT_TRUE(util::Base64DecodeAppend(base64, &plaintext));
+    auto encrypted = oracle.Encrypt(plaintext);
+    for (unsigned max_in_flight : {1u, 4u, 64u}) {
+      PaddingOracleResult result = PaddingOracleDecrypt(
+          &oracle, encrypted.iv, encrypted.ciphertext, max_in_flight);
+      EXPECT_EQ(plaintext, Padding::Pkcs7Decode(result.plaintext));
+      ASSERT_EQ(encrypted.ciphertext.size() / 16, result.blocks.size());
+      for (const auto& block : result.blocks) {
+        // At least one guess per byte, at most all of them plus the check.
+        EXPECT_GE(block.queries, 16);
+        EXPECT_LE(block.queries, 16 * 256 + 256);
+      }
+    }
+  }
+}
+
+// Decrypts every block to itself XOR the IV, so the intermediate that
+// RecoverIntermediate finds is the block itself and the guesses it makes are
+// known in advance.
+class XorOracle : public PaddingOracle {
+ public:
+  bool ValidPadding(std::string_view iv,
+                    std::string_view ciphertext) override {
+    std::string plaintext(ciphertext);
+    for (size_t i = 0; i < 16; i++) {
+      plaintext[i] ^= iv[i];
+    }
+    return Padding::Pkcs7Unpad(plaintext, 16).has_value();
+  }
+};
+
+// With byte 14 of the intermediate being 0x02, the all-zero forged IV makes
+// guess 1 for the last byte produce 0x02 0x02, which is valid padding; it
+// comes before the real 0x01 guess 2 and must not be taken for it.
+TEST(PaddingOracleTest, LongerPaddingIsNotMistakenForOneByte) {
+  XorOracle oracle;
+  std::string block(16, 0);
+  block[14] = 0x02;
+  block[15] = 0x03;
+  const std::string iv(16, 0);
+  PaddingOracleResult result = PaddingOracleDecrypt(&oracle, iv, block, 1);
+  EXPECT_EQ(block, result.plaintext);
+
+  // One worker tries the guesses in order: bytes 0 to 14 take
+  // `intermediate ^ pad` + 1 queries each, the last byte takes guesses 0, 1
+  // and 2 plus the extra check of 1 and of 2.
+  uint64_t expected = 3 + 2;
+  for (size_t pos = 0; pos < 15; pos++) {
+    expected += (static_cast<uint8_t>(block[pos]) ^ (16 - pos)) + 1;
+  }
+  ASSERT_EQ(1, result.blocks.size());
+  EXPECT_EQ(expected, result.blocks[0].queries);
+}
+
+TEST(PaddingOracleTest, InvalidInput) {
+  CbcPaddingOracle oracle;
+  EXPECT_THROW(PaddingOracleDecrypt(&oracle, std::string(16, 0), "abc"),
+               std::invalid_argument);
+  EXPECT_THROW(PaddingOracleDecrypt(&oracle, "short", std::string(16, 0)),
+               std::invalid_argument);
+  EXPECT_TRUE(PaddingOracleDecrypt(&oracle, std::string(16, 0), "")
+                  .plaintext.empty());
+}
+
+// Against a remote-like oracle the wall time is dominated by round trips, so
+// keeping many queries in flight is what makes the attack fast.
+TEST(PaddingOracleTest, SaturatesSlowOracle) {
+  CbcPaddingOracle oracle;
+  SlowOracle slow(&oracle, std::chrono::microseconds(200));
+  std::string plaintext;
+  ASSERT_TRUE(util::Base64DecodeAppend(kStrings[1], &plaintext));
+  auto encrypted = oracle.Encrypt(plaintext);
+
+  constexpr unsigned kMaxInFlight = 64;
+  const auto start = std::chrono::steady_clock::now();
+  PaddingOracleResult result = PaddingOracleDecrypt(
+      &slow, encrypted.iv, encrypted.ciphertext, kMaxInFlight);
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  EXPECT_EQ(plaintext, Padding::Pkcs7Decode(result.plaintext));
+  EXPECT_GT(slow.peak(), result.blocks.size());
+  EXPECT_LE(slow.peak(), kMaxInFlight);
+
+  for (size_t i = 0; i < result.blocks.size(); i++) {
+    std::cout << "block " << i << ": " << result.blocks[i].queries
+              << " queries in " << result.blocks[i].seconds << " s"
+              << std::endl;
+  }
+  std::cout << result.queries() << " queries in " << seconds << " s, "
+            << slow.peak() << " in flight at most" << std::endl;
+}
+
+}  // namespace
+}  // namespace cryptopals
@@ -0,0 +1,396 @@
+#include "codec.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CRYPTOPALS_X86 1
+#endif
+
+namespace cryptopals::util {
+
+namespace {
+
+constexpr uint8_t kInvalid = 0xff;
+
+constexpr std::array<uint8_t, 256> MakeHexTable() {
+  std::array<uint8_t, 256> table{};
+  for (int c = 0; c < 256; c++) {
+    table[c] = kInvalid;
+  }
+  for (int c = '0'; c <= '9'; c++) {
+    table[c] = c - '0';
+  }
+  for (int c = 'a'; c <= 'f'; c++) {
+    table[c] = c - 'a' + 10;
+    table[c - 'a' + 'A'] = c - 'a' + 10;
+  }
+  return table;
+}
+
+constexpr std::array<uint8_t, 256> MakeBase64Table() {
+  std::array<uint8_t, 256> table{};
+  for (int c = 0; c < 256; c++) {
+    table[c] = kInvalid;
+  }
+  for (int c = 'A'; c <= 'Z'; c++) {
+    table[c] = c - 'A';
+  }
+  for (int c = 'a'; c <= 'z'; c++) {
+    table[c] = c - 'a' + 26;
+  }
+  for (int c = '0'; c <= '9'; c++) {
+    table[c] = c - '0' + 52;
+  }
+  table['+'] = 62;
+  table['/'] = 63;
+  return table;
+}
+
+constexpr std::array<uint8_t, 256> kHexTable = MakeHexTable();
+constexpr std::array<uint8_t, 256> kBase64Table = MakeBase64Table();
+
+bool IsSpace(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' ||
+         c == '\f';
+}
+
+bool HexDecodeScalar(const char* hex, size_t size, uint8_t* out) {
+  for (size_t i = 0; i + 1 < size; i += 2) {
+    uint8_t hi = kHexTable[static_cast<uint8_t>(hex[i])];
+    uint8_t lo = kHexTable[static_cast<uint8_t>(hex[i + 1])];
+    if ((hi | lo) == kInvalid) {
+      return false;
+    }
+    out[i / 2] = hi << 4u | lo;
+  }
+  return true;
+}
+
+// `size` must be a multiple of 4 and the input must not contain padding.
+bool Base64DecodeQuads(const char* in, size_t size, uint8_t* out) {
+  for (size_t i = 0; i < size; i += 4) {
+    uint32_t a = kBase64Table[static_cast<uint8_t>(in[i])];
+    uint32_t b = kBase64Table[static_cast<uint8_t>(in[i + 1])];
+    uint32_t c = kBase64Table[static_cast<uint8_t>(in[i + 2])];
+    uint32_t d = kBase64Table[static_cast<uint8_t>(in[i + 3])];
+    if ((a | b | c | d) == kInvalid) {
+      return false;
+    }
+    uint32_t word = a << 18u | b << 12u | c << 6u | d;
+    out[i / 4 * 3] = word >> 16u;
+    out[i / 4 * 3 + 1] = word >> 8u;
+    out[i / 4 * 3 + 2] = word;
+  }
+  return true;
+}
+
+// Decodes the end of the input, which may be padded or cut short.
+bool Base64DecodeScalar(const char* in, size_t size, uint8_t* out,
+                        size_t* out_size) {
+  size_t n = size;
+  while (n > 0 && size - n < 2 && in[n - 1] == '=') {
+    n--;
+  }
+  if ((n != size && size % 4 != 0) || n % 4 == 1) {
+    return false;
+  }
+  size_t full = n / 4 * 4;
+  if (!Base64DecodeQuads(in, full, out)) {
+    return false;
+  }
+  out += full / 4 * 3;
+  *out_size = full / 4 * 3;
+  if (n == full) {
+    return true;
+  }
+  // Two or three characters left, giving one or two bytes.
+  uint32_t word = 0;
+  for (size_t i = full; i < n; i++) {
+    uint8_t value = kBase64Table[static_cast<uint8_t>(in[i])];
+    if (value == kInvalid) {
+      return false;
+    }
+    word = word << 6u | value;
+  }
+  word <<= 6u * (4 - (n - full));
+  out[0] = word >> 16u;
+  if (n - full == 3) {
+    out[1] = word >> 8u;
+  }
+  *out_size += n - full - 1;
+  return true;
+}
+
+#ifdef CRYPTOPALS_X86
+__attribute__((target("avx2"))) bool HexDecodeAvx2(const char* hex,
+                                                   size_t size,
+                                                   uint8_t* out) {
+  const __m256i below_zero = _mm256_set1_epi8('0' - 1);
+  const __m256i above_nine = _mm256_set1_epi8('9' + 1);
+  const __m256i below_a = _mm256_set1_epi8('a' - 1);
+  const __m256i above_f = _mm256_set1_epi8('f' + 1);
+  const __m256i case_bit = _mm256_set1_epi8(0x20);
+  // maddubs weights: high nibble * 16 + low nibble for each pair of bytes.
+  const __m256i weights = _mm256_set1_epi16(0x0110);
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hex + i));
+    // Bytes >= 0x80 are negative in the signed compares and fail both tests.
+    __m256i is_digit = _mm256_and_si256(_mm256_cmpgt_epi8(c, below_zero),
+                                        _mm256_cmpgt_epi8(above_nine, c));
+    __m256i lower = _mm256_or_si256(c, case_bit);
+    __m256i is_alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, below_a),
+                                        _mm256_cmpgt_epi8(above_f, lower));
+    if (_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_alpha)) != -1) {
+      return false;
+    }
+    __m256i digit = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+    __m256i alpha = _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10));
+    __m256i nibbles = _mm256_blendv_epi8(alpha, digit, is_digit);
+    __m256i pairs = _mm256_maddubs_epi16(nibbles, weights);
+    // packus works per 128-bit lane, gather the two low quadwords.
+    __m256i packed = _mm256_packus_epi16(pairs, pairs);
+    packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i / 2),
+                     _mm256_castsi256_si128(packed));
+  }
+  return HexDecodeScalar(hex + i, size - i, out + i / 2);
+}
+
+// Lookup-and-pack base64 decoding after Muła and Lemire, "Faster Base64
+// Encoding and Decoding using AVX2 Instructions". The nibble lookups flag
+// characters outside the alphabet, a third lookup gives the offset from ASCII
+// to the 6-bit value, and two multiply-adds pack 4 x 6 bits into 3 bytes.
+__attribute__((target("avx2"))) bool Base64DecodeAvx2(const char* in,
+                                                      size_t size,
+                                                      uint8_t* out,
+                                                      size_t* out_size) {
+  const __m256i lut_lo = _mm256_setr_epi8(
+      0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a,
+      0x1b, 0x1b, 0x1b, 0x1a, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+      0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+  const __m256i lut_hi = _mm256_setr_epi8(
+      0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m256i lut_roll = _mm256_setr_epi8(
+      0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,  //
+      0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+  const __m256i shuffle = _mm256_setr_epi8(
+      2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,  //
+      2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  const __m256i permute = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+  size_t i = 0;
+  uint8_t* dst = out;
+  // Each step stores 32 bytes of which 24 are valid. Stopping 12 characters
+  // early keeps the store inside Base64DecodedMaxSize(size) and leaves any
+  // padding to the scalar tail.
+  for (; i + 44 <= size; i += 32) {
+    __m256i str = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask_2f);
+    __m256i lo_nibbles = _mm256_and_si256(str, mask_2f);
+    __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+    __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+    if (!_mm256_testz_si256(lo, hi)) {
+      return false;
+    }
+    __m256i eq_2f = _mm256_cmpeq_epi8(str, mask_2f);
+    __m256i roll =
+        _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+    str = _mm256_add_epi8(str, roll);
+    __m256i merged =
+        _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+    merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+    merged = _mm256_shuffle_epi8(merged, shuffle);
+    merged = _mm256_permutevar8x32_epi32(merged, permute);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), merged);
+    dst += 24;
+  }
+  size_t tail_size;
+  if (!Base64DecodeScalar(in + i, size - i, dst, &tail_size)) {
+    return false;
+  }
+  *out_size = (dst - out) + tail_size;
+  return true;
+}
+#endif
+
+using HexKernel = bool (*)(const char*, size_t, uint8_t*);
+using Base64Kernel = bool (*)(const char*, size_t, uint8_t*, size_t*);
+
+#ifdef CRYPTOPALS_X86
+bool HasAvx2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+#endif
+
+HexKernel SelectHexKernel() {
+#ifdef CRYPTOPALS_X86
+  if (HasAvx2()) {
+    return HexDecodeAvx2;
+  }
+#endif
+  return HexDecodeScalar;
+}
+
+Base64Kernel SelectBase64Kernel() {
+#ifdef CRYPTOPALS_X86
+  if (HasAvx2()) {
+    return Base64DecodeAvx2;
+  }
+#endif
+  return Base64DecodeScalar;
+}
+
+std::string_view TrimLine(std::string_view line) {
+  if (!line.empty() && line.back() == '\r') {
+    line.remove_suffix(1);
+  }
+  return line;
+}
+
+// Shared driver of the *DecodeLines functions. `decode(line, out)` writes the
+// record at `out` and returns its size, or -1 if the line is malformed.
+template <typename Decode>
+bool DecodeLines(std::string_view text, std::string* buffer,
+                 std::vector<size_t>* offsets, Decode decode) {
+  // No line decodes to more than its length plus one byte (base64 without
+  // padding), and all lines but the last are followed by a line break.
+  buffer->resize(text.size() + 1);
+  offsets->assign(1, 0);
+  auto* out = reinterpret_cast<uint8_t*>(buffer->data());
+  size_t pos = 0;
+  while (pos < text.size()) {
+    size_t end = text.find('\n', pos);
+    if (end == std::string_view::npos) {
+      end = text.size();
+    }
+    long size = decode(TrimLine(text.substr(pos, end - pos)),
+                       out + offsets->back());
+    if (size < 0) {
+      buffer->clear();
+      offsets->assign(1, 0);
+      return false;
+    }
+    offsets->push_back(offsets->back() + size);
+    pos = end + 1;
+  }
+  buffer->resize(offsets->back());
+  return true;
+}
+
+}  // namespace
+
+bool HexDecode(const char* hex, size_t size, uint8_t* out) {
+  static const HexKernel kernel = SelectHexKernel();
+  if (size % 2 != 0) {
+    return false;
+  }
+  // A single AES block is not worth the indirect call.
+  if (size < 64) {
+    return HexDecodeScalar(hex, size, out);
+  }
+  return kernel(hex, size, out);
+}
+
+bool HexDecodeAppend(std::string_view hex, std::string* out) {
+  size_t offset = out->size();
+  out->resize(offset + hex.size() / 2);
+  if (!HexDecode(hex.data(), hex.size(),
+                 reinterpret_cast<uint8_t*>(out->data()) + offset)) {
+    out->resize(offset);
+    return false;
+  }
+  return true;
+}
+
+bool Base64Decode(const char* base64, size_t size, uint8_t* out,
+                  size_t* out_size) {
+  static const Base64Kernel kernel = SelectBase64Kernel();
+  return kernel(base64, size, out, out_size);
+}
+
+bool Base64DecodeAppend(std::string_view base64, std::string* out) {
+  const size_t offset = out->size();
+  out->resize(offset + Base64DecodedMaxSize(base64.size()));
+  auto* dst = reinterpret_cast<uint8_t*>(out->data()) + offset;
+  std::string carry;
+  bool padded = false;
+  auto flush = [&](const char* data, size_t size) {
+    size_t written;
+    if (padded || !Base64Decode(data, size, dst, &written)) {
+      return false;
+    }
+    dst += written;
+    padded = size % 4 != 0 || data[size - 1] == '=';
+    return true;
+  };
+  // Lines holding whole quads, as in wrapped files, are decoded straight from
+  // the input. Otherwise the line is split at whitespace and the pieces are
+  // gathered in `carry` until they make whole quads.
+  bool ok = true;
+  size_t pos = 0;
+  while (ok && pos < base64.size()) {
+    size_t end = base64.find('\n', pos);
+    if (end == std::string_view::npos) {
+      end = base64.size();
+    }
+    std::string_view line = base64.substr(pos, end - pos);
+    pos = end + 1;
+    while (!line.empty() && IsSpace(line.back())) {
+      line.remove_suffix(1);
+    }
+    while (!line.empty() && IsSpace(line.front())) {
+      line.remove_prefix(1);
+    }
+    if (line.empty() ||
+        (carry.empty() && line.size() % 4 == 0 &&
+         flush(line.data(), line.size()))) {
+      continue;
+    }
+    for (char c : line) {
+      if (!IsSpace(c)) {
+        carry.push_back(c);
+      }
+    }
+    if (carry.size() % 4 == 0) {
+      ok = flush(carry.data(), carry.size());
+      carry.clear();
+    }
+  }
+  if (ok && !carry.empty()) {
+    ok = flush(carry.data(), carry.size());
+  }
+  out->resize(ok ? dst - reinterpret_cast<uint8_t*>(out->data()) : offset);
+  return ok;
+}
+
+bool HexDecodeLines(std::string_view text, std::string* buffer,
+                    std::vector<size_t>* offsets) {
+  return DecodeLines(text, buffer, offsets,
+                     [](std::string_view line, uint8_t* out) -> long {
+                       if (!HexDecode(line.data(), line.size(), out)) {
+                         return -1;
+                       }
+                       return line.size() / 2;
+                     });
+}
+
+bool Base64DecodeLines(std::string_view text, std::string* buffer,
+                       std::vector<size_t>* offsets) {
+  return DecodeLines(text, buffer, offsets,
+                     [](std::string_view line, uint8_t* out) -> long {
+                       size_t size;
+                       if (!Base64Decode(line.data(), line.size(), out,
+                                         &size)) {
+                         return -1;
+                       }
+                       return size;
+                     });
+}
+
+}  // namespace cryptopals::util
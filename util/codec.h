@@ -0,0 +1,53 @@
+#ifndef CRYPTOPALS_UTIL_CODEC_H_
+#define CRYPTOPALS_UTIL_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cryptopals::util {
+
+// Hex and base64 decoders that write into caller buffers. With AVX2 they
+// decode 32 characters per step; otherwise a table-driven scalar loop is used.
+
+// Decodes `size` hex digits (either case) into size / 2 bytes at `out`.
+// Returns false if `size` is odd or a character is not a hex digit, in which
+// case `out` may be partially written.
+bool HexDecode(const char* hex, size_t size, uint8_t* out);
+
+// Appends the bytes encoded by `hex` to `out`. On failure returns false and
+// leaves `out` unchanged.
+bool HexDecodeAppend(std::string_view hex, std::string* out);
+
+// Number of bytes Base64Decode may write for `size` input characters.
+constexpr size_t Base64DecodedMaxSize(size_t size) {
+  return (size + 3) / 4 * 3;
+}
+
+// Decodes `size` characters of standard base64 (RFC 4648 alphabet, '='
+// padding optional) into `out`, which must hold Base64DecodedMaxSize(size)
+// bytes. Whitespace is not accepted here. Stores the decoded size in
+// `*out_size` and returns true, or returns false on malformed input.
+bool Base64Decode(const char* base64, size_t size, uint8_t* out,
+                  size_t* out_size);
+
+// Appends the bytes encoded by `base64` to `out`, skipping whitespace (e.g.
+// the line breaks of a wrapped file) between characters. On failure returns
+// false and leaves `out` unchanged.
+bool Base64DecodeAppend(std::string_view base64, std::string* out);
+
+// Decode a multi-line file with one encoded record per line into a flat
+// buffer: record i is buffer[offsets[i], offsets[i + 1]), so `offsets` ends
+// up with one entry more than there are records. A trailing '\r' on a line is
+// ignored and a final line break does not start an empty record. Both outputs
+// are overwritten. Returns false if any line is malformed.
+bool HexDecodeLines(std::string_view text, std::string* buffer,
+                    std::vector<size_t>* offsets);
+bool Base64DecodeLines(std::string_view text, std::string* buffer,
+                       std::vector<size_t>* offsets);
+
+}  // namespace cryptopals::util
+
+#endif  // CRYPTOPALS_UTIL_CODEC_H_
@@ -0,0 +1,134 @@
+#include "codec.h"
+
+#include <cctype>
+#include <random>
+
+#include "absl/strings/escaping.h"
+#include "gtest/gtest.h"
+
+namespace cryptopals::util {
+namespace {
+
+std::string RandomBytes(size_t size, std::mt19937* rng) {
+  std::string bytes(size, 0);
+  for (char& c : bytes) c = static_cast<char>((*rng)());
+  return bytes;
+}
+
+TEST(CodecTest, HexMatchesAbsl) {
+  std::mt19937 rng(42);
+  // Sizes around the vector width and the scalar cutoff, in both cases.
+  for (size_t size = 0; size < 200; size++) {
+    std::string bytes = RandomBytes(size, &rng);
+    std::string hex = absl::BytesToHexString(bytes);
+    if (size % 2) {
+      for (char& c : hex) c = static_cast<char>(std::toupper(c));
+    }
+    std::string out = "prefix";
+    ASSERT_TRUE(HexDecodeAppend(hex, &out)) << size;
+    EXPECT_EQ("prefix" + bytes, out);
+  }
+}
+
+TEST(CodecTest, HexRejectsInvalid) {
+  std::string out = "keep";
+  EXPECT_FALSE(HexDecodeAppend("abc", &out));
+  std::string hex(128, 'a');
+  for (char bad : {'g', 'G', '/', ':', '@', '`', ' ', '\x80', '\xff'}) {
+    for (size_t pos : {0, 31, 100, 127}) {
+      std::string copy = hex;
+      copy[pos] = bad;
+      EXPECT_FALSE(HexDecodeAppend(copy, &out)) << bad << " at " << pos;
+    }
+  }
+  EXPECT_EQ("keep", out);
+}
+
+TEST(CodecTest, Base64MatchesAbsl) {
+  std::mt19937 rng(7);
+  for (size_t size = 0; size < 300; size++) {
+    std::string bytes = RandomBytes(size, &rng);
+    std::string padded = absl::Base64Escape(bytes);
+    std::string unpadded = padded.substr(0, padded.find('='));
+    for (const std::string& base64 : {padded, unpadded}) {
+      std::string out;
+      ASSERT_TRUE(Base64DecodeAppend(base64, &out)) << base64;
+      EXPECT_EQ(bytes, out);
+
+      std::string raw(Base64DecodedMaxSize(base64.size()), 0);
+      size_t raw_size;
+      ASSERT_TRUE(Base64Decode(base64.data(), base64.size(),
+                               reinterpret_cast<uint8_t*>(raw.data()),
+                               &raw_size));
+      raw.resize(raw_size);
+      EXPECT_EQ(bytes, raw);
+    }
+  }
+}
+
+TEST(CodecTest, Base64RejectsInvalid) {
+  std::string out = "keep";
+  std::string base64(128, 'Q');
+  for (char bad : {'=', '-', '_', '.', ':', '@', '[', '`', '{', '\x80'}) {
+    for (size_t pos : {0, 31, 63, 100}) {
+      std::string copy = base64;
+      copy[pos] = bad;
+      EXPECT_FALSE(Base64DecodeAppend(copy, &out)) << bad << " at " << pos;
+    }
+  }
+  for (const char* bad : {"Q", "QUJD=", "QQ===", "QQ==QUJD", "QQ= QUJD"}) {
+    EXPECT_FALSE(Base64DecodeAppend(bad, &out)) << bad;
+  }
+  EXPECT_EQ("keep", out);
+}
+
+TEST(CodecTest, Base64SkipsWhitespace) {
+  std::mt19937 rng(3);
+  std::string bytes = RandomBytes(1000, &rng);
+  std::string base64 = absl::Base64Escape(bytes);
+  // Wrapped at 60 columns like the challenge files, and at odd widths where
+  // quads straddle the line breaks.
+  for (size_t width : {60, 61, 7, 1}) {
+    std::string wrapped;
+    for (size_t i = 0; i < base64.size(); i += width) {
+      wrapped += base64.substr(i, width) + (i % 2 ? "\r\n" : " \n");
+    }
+    std::string out;
+    ASSERT_TRUE(Base64DecodeAppend(wrapped, &out)) << width;
+    EXPECT_EQ(bytes, out);
+  }
+}
+
+TEST(CodecTest, DecodeLines) {
+  std::mt19937 rng(5);
+  std::vector<std::string> records;
+  std::string hex_text, base64_text;
+  for (size_t size : {0, 16, 1, 100, 37, 0, 64}) {
+    records.push_back(RandomBytes(size, &rng));
+    hex_text += absl::BytesToHexString(records.back()) + "\n";
+    base64_text += absl::Base64Escape(records.back()) + "\r\n";
+  }
+  std::string buffer;
+  std::vector<size_t> offsets;
+  for (bool base64 : {false, true}) {
+    ASSERT_TRUE(base64 ? Base64DecodeLines(base64_text, &buffer, &offsets)
+                       : HexDecodeLines(hex_text, &buffer, &offsets));
+    ASSERT_EQ(records.size() + 1, offsets.size());
+    EXPECT_EQ(0, offsets[0]);
+    EXPECT_EQ(buffer.size(), offsets.back());
+    for (size_t i = 0; i < records.size(); i++) {
+      EXPECT_EQ(records[i],
+                buffer.substr(offsets[i], offsets[i + 1] - offsets[i]));
+    }
+  }
+  // No final line break
+  ASSERT_TRUE(HexDecodeLines("00\nff", &buffer, &offsets));
+  EXPECT_EQ(std::string("\x00\xff", 2), buffer);
+  EXPECT_EQ(3, offsets.size());
+
+  EXPECT_FALSE(HexDecodeLines("00\nfg\n", &buffer, &offsets));
+  EXPECT_FALSE(Base64DecodeLines("QQ==\nQ\n", &buffer, &offsets));
+}
+
+}  // namespace
+}  // namespace cryptopals::util
@@ -0,0 +1,141 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace cryptopals::util {
+
+namespace {
+
+[[noreturn]] void ThrowErrno(const std::string& what) {
+  throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+class ScopedFd {
+ public:
+  explicit ScopedFd(int fd) : fd_(fd) {}
+  ~ScopedFd() {
+    if (fd_ >= 0) close(fd_);
+  }
+  ScopedFd(const ScopedFd&) = delete;
+  ScopedFd& operator=(const ScopedFd&) = delete;
+  int get() const { return fd_; }
+
+ private:
+  int fd_;
+};
+
+void AppendPath(std::string_view list, std::vector<std::string>* dirs) {
+  while (!list.empty()) {
+    size_t end = std::min(list.find(':'), list.size());
+    if (end > 0) {
+      dirs->emplace_back(list.substr(0, end));
+    }
+    list.remove_prefix(std::min(end + 1, list.size()));
+  }
+}
+
+}  // namespace
+
+MappedFile MappedFile::Open(const std::string& path) {
+  ScopedFd fd(open(path.c_str(), O_RDONLY));
+  if (fd.get() < 0) ThrowErrno("open " + path);
+  struct stat st {};
+  if (fstat(fd.get(), &st) != 0) ThrowErrno("stat " + path);
+
+  MappedFile file;
+  if (S_ISREG(st.st_mode) && st.st_size > 0) {
+    auto size = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+    if (addr != MAP_FAILED) {
+      file.mapping_ = addr;
+      file.data_ = std::string_view(static_cast<const char*>(addr), size);
+      return file;
+    }
+  }
+  // Empty, special or unmappable file: read whatever it yields.
+  char buffer[64 * 1024];
+  for (;;) {
+    ssize_t n = read(fd.get(), buffer, sizeof(buffer));
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      ThrowErrno("read " + path);
+    }
+    if (n == 0) break;
+    file.owned_.append(buffer, n);
+  }
+  file.data_ = file.owned_;
+  return file;
+}
+
+MappedFile MappedFile::OpenData(std::string_view name) {
+  return Open(FindDataFile(name));
+}
+
+MappedFile::~MappedFile() { Unmap(); }
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+  *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    Unmap();
+    mapping_ = std::exchange(other.mapping_, nullptr);
+    owned_ = std::move(other.owned_);
+    // A short owned string lives inside the object, so re-point the view.
+    data_ = mapping_ != nullptr ? other.data_ : std::string_view(owned_);
+    other.owned_.clear();
+    other.data_ = {};
+  }
+  return *this;
+}
+
+void MappedFile::AdviseSequential() const {
+  if (mapping_ != nullptr) {
+    madvise(mapping_, data_.size(), MADV_SEQUENTIAL);
+  }
+}
+
+void MappedFile::Unmap() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, data_.size());
+    mapping_ = nullptr;
+  }
+  data_ = {};
+}
+
+std::vector<std::string> DataSearchPath() {
+  std::vector<std::string> dirs = {"."};
+  if (const char* env = std::getenv("CRYPTOPALS_DATA_PATH")) {
+    AppendPath(env, &dirs);
+  }
+#ifdef CRYPTOPALS_SOURCE_DATA_PATH
+  AppendPath(CRYPTOPALS_SOURCE_DATA_PATH, &dirs);
+#endif
+  return dirs;
+}
+
+std::string FindDataFile(std::string_view name) {
+  if (!name.empty() && name.front() == '/') {
+    return std::string(name);
+  }
+  for (const std::string& dir : DataSearchPath()) {
+    std::string path = dir + "/" + std::string(name);
+    if (access(path.c_str(), R_OK) == 0) {
+      return path;
+    }
+  }
+  throw std::runtime_error("Cannot find data file " + std::string(name) +
+                           " (set CRYPTOPALS_DATA_PATH)");
+}
+
+}  // namespace cryptopals::util
@@ -0,0 +1,100 @@
+#ifndef CRYPTOPALS_UTIL_MAPPED_FILE_H_
+#define CRYPTOPALS_UTIL_MAPPED_FILE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cryptopals::util {
+
+// Read-only contents of a whole file. Regular files are mapped, so loading
+// costs one page-cache mapping and nothing is copied; files that cannot be
+// mapped (pipes, /proc) are read into an owned buffer instead. The view
+// returned by data() stays valid for the lifetime of the MappedFile.
+class MappedFile {
+ public:
+  // Throws std::runtime_error if `path` cannot be opened or read.
+  static MappedFile Open(const std::string& path);
+  // Open(FindDataFile(name)).
+  static MappedFile OpenData(std::string_view name);
+
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  std::string_view data() const { return data_; }
+  size_t size() const { return data_.size(); }
+
+  // Tells the kernel the contents will be read front to back, so it reads
+  // ahead aggressively and drops pages behind.
+  void AdviseSequential() const;
+
+ private:
+  void Unmap();
+
+  void* mapping_ = nullptr;
+  std::string owned_;  // used when the file could not be mapped
+  std::string_view data_;
+};
+
+// Iterates over the lines of `text` without copying:
+//   for (std::string_view line : Lines(file.data())) { ... }
+// A trailing '\r' is dropped from each line and a final line break does not
+// start an empty line, as in the *DecodeLines functions of codec.h.
+class Lines {
+ public:
+  class Iterator {
+   public:
+    Iterator(std::string_view text, size_t pos) : text_(text), pos_(pos) {
+      FindEnd();
+    }
+    std::string_view operator*() const {
+      std::string_view line = text_.substr(pos_, end_ - pos_);
+      if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+      }
+      return line;
+    }
+    Iterator& operator++() {
+      pos_ = std::min(end_ + 1, text_.size());
+      FindEnd();
+      return *this;
+    }
+    bool operator!=(const Iterator& other) const { return pos_ != other.pos_; }
+
+   private:
+    void FindEnd() {
+      end_ = std::min(text_.find('\n', pos_), text_.size());
+    }
+
+    std::string_view text_;
+    size_t pos_;
+    size_t end_ = 0;
+  };
+
+  explicit Lines(std::string_view text) : text_(text) {}
+  Iterator begin() const { return Iterator(text_, 0); }
+  Iterator end() const { return Iterator(text_, text_.size()); }
+
+ private:
+  std::string_view text_;
+};
+
+// Directories searched by FindDataFile, in order: the working directory, the
+// entries of the colon-separated CRYPTOPALS_DATA_PATH environment variable,
+// then the challenge directories of the source tree.
+std::vector<std::string> DataSearchPath();
+
+// Returns the first existing `dir/name` over DataSearchPath(), or `name`
+// itself if it is an absolute path. Throws std::runtime_error if there is
+// none.
+std::string FindDataFile(std::string_view name);
+
+}  // namespace cryptopals::util
+
+#endif  // CRYPTOPALS_UTIL_MAPPED_FILE_H_
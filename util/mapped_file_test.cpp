@@ -0,0 +1,77 @@
+#include "mapped_file.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#include "gtest/gtest.h"
+
+namespace cryptopals::util {
+namespace {
+
+std::string WriteTempFile(const std::string& name, const std::string& text) {
+  std::string path = ::testing::TempDir() + name;
+  std::ofstream(path, std::ios::binary) << text;
+  return path;
+}
+
+std::vector<std::string> AllLines(std::string_view text) {
+  std::vector<std::string> lines;
+  for (std::string_view line : Lines(text)) {
+    lines.emplace_back(line);
+  }
+  return lines;
+}
+
+TEST(MappedFileTest, MapsWholeFile) {
+  std::string text(100000, 'x');
+  text[99999] = 'y';
+  MappedFile file = MappedFile::Open(WriteTempFile("mapped_big", text));
+  file.AdviseSequential();
+  EXPECT_EQ(text, file.data());
+
+  // Moving keeps the view valid, also for a small file held in a buffer.
+  MappedFile moved = std::move(file);
+  EXPECT_EQ(text, moved.data());
+  EXPECT_TRUE(file.data().empty());
+  MappedFile empty = MappedFile::Open(WriteTempFile("mapped_empty", ""));
+  EXPECT_EQ(0, empty.size());
+  moved = std::move(empty);
+  EXPECT_EQ(0, moved.size());
+}
+
+TEST(MappedFileTest, ReadsUnmappableFile) {
+  MappedFile file = MappedFile::Open("/proc/self/status");
+  EXPECT_NE(std::string_view::npos, file.data().find("Pid:"));
+  MappedFile moved = std::move(file);
+  EXPECT_NE(std::string_view::npos, moved.data().find("Pid:"));
+}
+
+TEST(MappedFileTest, MissingFile) {
+  EXPECT_THROW(MappedFile::Open("/nonexistent/file"), std::runtime_error);
+  EXPECT_THROW(FindDataFile("nonexistent.txt"), std::runtime_error);
+}
+
+TEST(MappedFileTest, FindsDataFileOnSearchPath) {
+  std::string dir = ::testing::TempDir();
+  if (!dir.empty() && dir.back() == '/') dir.pop_back();
+  WriteTempFile("mapped_data.txt", "data");
+  setenv("CRYPTOPALS_DATA_PATH", ("/nonexistent:" + dir).c_str(), 1);
+  EXPECT_EQ(dir + "/mapped_data.txt", FindDataFile("mapped_data.txt"));
+  EXPECT_EQ("data", MappedFile::OpenData("mapped_data.txt").data());
+  unsetenv("CRYPTOPALS_DATA_PATH");
+  // The challenge files are found without copying them next to the binary.
+  EXPECT_FALSE(MappedFile::OpenData("1984.txt").data().empty());
+}
+
+TEST(LinesTest, Split) {
+  EXPECT_TRUE(AllLines("").empty());
+  EXPECT_EQ(std::vector<std::string>({"a"}), AllLines("a"));
+  EXPECT_EQ(std::vector<std::string>({"a"}), AllLines("a\n"));
+  EXPECT_EQ(std::vector<std::string>({"a", "", "bc"}), AllLines("a\r\n\nbc"));
+  EXPECT_EQ(std::vector<std::string>({"", ""}), AllLines("\n\r\n"));
+}
+
+}  // namespace
+}  // namespace cryptopals::util
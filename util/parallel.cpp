@@ -0,0 +1,67 @@
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cryptopals::util {
+
+unsigned DefaultThreadCount() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ParallelFor(size_t count, size_t grain,
+                 const std::function<void(size_t begin, size_t end)>& fn,
+                 unsigned threads) {
+  if (count == 0) {
+    return;
+  }
+  grain = std::max<size_t>(grain, 1);
+  size_t ranges = (count + grain - 1) / grain;
+  if (threads == 0) {
+    threads = DefaultThreadCount();
+  }
+  threads = static_cast<unsigned>(std::min<size_t>(threads, ranges));
+  if (threads == 1) {
+    // Nothing to share, run inline without spawning anything.
+    for (size_t begin = 0; begin < count; begin += grain) {
+      fn(begin, std::min(begin + grain, count));
+    }
+    return;
+  }
+
+  std::atomic<size_t> next_range{0};
+  std::exception_ptr error;
+  std::mutex error_mu;
+  auto worker = [&]() {
+    for (size_t r = next_range++; r < ranges; r = next_range++) {
+      try {
+        fn(r * grain, std::min((r + 1) * grain, count));
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mu);
+        if (!error) {
+          error = std::current_exception();
+        }
+        next_range = ranges;  // stop handing out more work
+      }
+    }
+  };
+
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  for (unsigned i = 1; i < threads; i++) {
+    pool.emplace_back(worker);
+  }
+  worker();  // the calling thread takes part as well
+  for (auto& t : pool) {
+    t.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+}  // namespace cryptopals::util
@@ -0,0 +1,23 @@
+#ifndef CRYPTOPALS_UTIL_PARALLEL_H_
+#define CRYPTOPALS_UTIL_PARALLEL_H_
+
+#include <cstddef>
+#include <functional>
+
+namespace cryptopals::util {
+
+// Number of hardware threads, at least 1.
+unsigned DefaultThreadCount();
+
+// Splits [0, count) into consecutive ranges of at most `grain` items and calls
+// `fn(begin, end)` for each range on up to `threads` threads (0 means
+// DefaultThreadCount()). Ranges are handed out dynamically, so `fn` must not
+// assume any ordering between them. Returns once every range is done; the
+// first exception thrown by `fn` is rethrown in the caller.
+void ParallelFor(size_t count, size_t grain,
+                 const std::function<void(size_t begin, size_t end)>& fn,
+                 unsigned threads = 0);
+
+}  // namespace cryptopals::util
+
+#endif  // CRYPTOPALS_UTIL_PARALLEL_H_
@@ -0,0 +1,43 @@
+#include "parallel.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace cryptopals::util {
+namespace {
+
+TEST(ParallelForTest, VisitEachIndexOnce) {
+  std::vector<std::atomic<int>> visited(1001);
+  ParallelFor(
+      visited.size(), 7,
+      [&](size_t begin, size_t end) {
+        EXPECT_LE(end - begin, 7);
+        for (size_t i = begin; i < end; i++) visited[i]++;
+      },
+      4);
+  for (const auto& v : visited) {
+    EXPECT_EQ(1, v);
+  }
+}
+
+TEST(ParallelForTest, Empty) {
+  bool called = false;
+  ParallelFor(0, 1, [&](size_t, size_t) { called = true; });
+  EXPECT_FALSE(called);
+}
+
+TEST(ParallelForTest, RethrowException) {
+  EXPECT_THROW(ParallelFor(
+                   100, 1,
+                   [](size_t begin, size_t) {
+                     if (begin == 42) throw std::runtime_error("42");
+                   },
+                   4),
+               std::runtime_error);
+}
+
+}  // namespace
+}  // namespace cryptopals::util